@@ -0,0 +1,209 @@
+#ifndef ATOMIC_H_
+#define ATOMIC_H_
+
+#include <type_traits>
+
+#include "atomic_var.h"
+
+// Atomic<T> -- typed atomic variable with explicit memory ordering, for lock-free code that
+// atomic_var.h's relaxed-only macros can't express:
+//   Atomic<Node*> head;
+//   Node* old = head.Load(MemoryOrder::kAcquire);
+//   do {
+//     node->next = old;
+//   } while (!head.CompareExchangeWeak(old, node, MemoryOrder::kRelease));
+//
+// Like atomic_var.h it maps onto the __atomic builtins, or onto the __sync builtins on compilers
+// that only have those. __sync operations are full barriers, so every order is treated as
+// kSeqCst there, and only integer and pointer types are supported. There is no mutex fallback:
+// a lock-based Atomic wouldn't be lock-free.
+
+#if !defined(__ATOMIC_RELAXED) && !defined(HAVE_ATOMIC)
+#  error "Atomic<T> needs either the __atomic or the __sync builtins"
+#endif
+
+enum class MemoryOrder {
+  kRelaxed,
+  kAcquire,
+  kRelease,
+  kAcqRel,
+  kSeqCst,
+};
+
+template <typename T>
+class Atomic {
+  static_assert(std::is_trivially_copyable<T>::value, "Atomic<T> needs a trivially copyable T");
+  static_assert(sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8,
+                "Atomic<T> needs a T of 1, 2, 4 or 8 bytes");
+#if !defined(__ATOMIC_RELAXED)
+  static_assert(std::is_integral<T>::value || std::is_pointer<T>::value,
+                "the __sync builtins only support integers and pointers");
+#endif
+
+ public:
+  Atomic() noexcept : value_() {}
+
+  constexpr Atomic(T value) noexcept : value_(value) {}
+
+  Atomic(const Atomic& other) = delete;
+
+  Atomic& operator=(const Atomic& other) = delete;
+
+#if defined(__ATOMIC_RELAXED)
+
+  T Load(MemoryOrder order = MemoryOrder::kSeqCst) const noexcept {
+    T value;
+    __atomic_load(&value_, &value, LoadBuiltin(order));
+    return value;
+  }
+
+  void Store(T value, MemoryOrder order = MemoryOrder::kSeqCst) noexcept {
+    __atomic_store(&value_, &value, StoreBuiltin(order));
+  }
+
+  T Exchange(T value, MemoryOrder order = MemoryOrder::kSeqCst) noexcept {
+    T old;
+    __atomic_exchange(&value_, &value, &old, Builtin(order));
+    return old;
+  }
+
+  // On failure expected is updated to the current value. The failure ordering is derived from
+  // order: the strongest one that has no release part.
+  bool CompareExchange(T& expected, T desired, MemoryOrder order = MemoryOrder::kSeqCst) noexcept {
+    return __atomic_compare_exchange(&value_, &expected, &desired, false, Builtin(order),
+                                     LoadBuiltin(order));
+  }
+
+  // May fail spuriously; cheaper in a retry loop on LL/SC machines.
+  bool CompareExchangeWeak(T& expected, T desired,
+                           MemoryOrder order = MemoryOrder::kSeqCst) noexcept {
+    return __atomic_compare_exchange(&value_, &expected, &desired, true, Builtin(order),
+                                     LoadBuiltin(order));
+  }
+
+  T FetchAdd(T value, MemoryOrder order = MemoryOrder::kSeqCst) noexcept {
+    static_assert(std::is_integral<T>::value, "FetchAdd needs an integer type");
+    return __atomic_fetch_add(&value_, value, Builtin(order));
+  }
+
+  T FetchSub(T value, MemoryOrder order = MemoryOrder::kSeqCst) noexcept {
+    static_assert(std::is_integral<T>::value, "FetchSub needs an integer type");
+    return __atomic_fetch_sub(&value_, value, Builtin(order));
+  }
+
+  T FetchOr(T value, MemoryOrder order = MemoryOrder::kSeqCst) noexcept {
+    static_assert(std::is_integral<T>::value, "FetchOr needs an integer type");
+    return __atomic_fetch_or(&value_, value, Builtin(order));
+  }
+
+  T FetchAnd(T value, MemoryOrder order = MemoryOrder::kSeqCst) noexcept {
+    static_assert(std::is_integral<T>::value, "FetchAnd needs an integer type");
+    return __atomic_fetch_and(&value_, value, Builtin(order));
+  }
+
+#else
+
+  T Load(MemoryOrder /*order*/ = MemoryOrder::kSeqCst) const noexcept {
+    return __sync_val_compare_and_swap(const_cast<T*>(&value_), T(), T());
+  }
+
+  void Store(T value, MemoryOrder /*order*/ = MemoryOrder::kSeqCst) noexcept {
+    __sync_synchronize();
+    *const_cast<volatile T*>(&value_) = value;
+    __sync_synchronize();
+  }
+
+  T Exchange(T value, MemoryOrder /*order*/ = MemoryOrder::kSeqCst) noexcept {
+    // __sync_lock_test_and_set is only an acquire barrier
+    __sync_synchronize();
+    return __sync_lock_test_and_set(&value_, value);
+  }
+
+  bool CompareExchange(T& expected, T desired,
+                       MemoryOrder /*order*/ = MemoryOrder::kSeqCst) noexcept {
+    T old = __sync_val_compare_and_swap(&value_, expected, desired);
+    if (old == expected) return true;
+    expected = old;
+    return false;
+  }
+
+  bool CompareExchangeWeak(T& expected, T desired,
+                           MemoryOrder order = MemoryOrder::kSeqCst) noexcept {
+    return CompareExchange(expected, desired, order);
+  }
+
+  T FetchAdd(T value, MemoryOrder /*order*/ = MemoryOrder::kSeqCst) noexcept {
+    static_assert(std::is_integral<T>::value, "FetchAdd needs an integer type");
+    return __sync_fetch_and_add(&value_, value);
+  }
+
+  T FetchSub(T value, MemoryOrder /*order*/ = MemoryOrder::kSeqCst) noexcept {
+    static_assert(std::is_integral<T>::value, "FetchSub needs an integer type");
+    return __sync_fetch_and_sub(&value_, value);
+  }
+
+  T FetchOr(T value, MemoryOrder /*order*/ = MemoryOrder::kSeqCst) noexcept {
+    static_assert(std::is_integral<T>::value, "FetchOr needs an integer type");
+    return __sync_fetch_and_or(&value_, value);
+  }
+
+  T FetchAnd(T value, MemoryOrder /*order*/ = MemoryOrder::kSeqCst) noexcept {
+    static_assert(std::is_integral<T>::value, "FetchAnd needs an integer type");
+    return __sync_fetch_and_and(&value_, value);
+  }
+
+#endif
+
+ private:
+#if defined(__ATOMIC_RELAXED)
+  static constexpr int Builtin(MemoryOrder order) {
+    return order == MemoryOrder::kRelaxed   ? __ATOMIC_RELAXED
+           : order == MemoryOrder::kAcquire ? __ATOMIC_ACQUIRE
+           : order == MemoryOrder::kRelease ? __ATOMIC_RELEASE
+           : order == MemoryOrder::kAcqRel  ? __ATOMIC_ACQ_REL
+                                            : __ATOMIC_SEQ_CST;
+  }
+
+  // A load has no release part and a store no acquire part; the builtins reject those orders,
+  // so the part that applies is kept. LoadBuiltin() is also the failure order of a CAS.
+  static constexpr int LoadBuiltin(MemoryOrder order) {
+    return order == MemoryOrder::kRelease  ? __ATOMIC_RELAXED
+           : order == MemoryOrder::kAcqRel ? __ATOMIC_ACQUIRE
+                                           : Builtin(order);
+  }
+
+  static constexpr int StoreBuiltin(MemoryOrder order) {
+    return order == MemoryOrder::kAcquire  ? __ATOMIC_RELAXED
+           : order == MemoryOrder::kAcqRel ? __ATOMIC_RELEASE
+                                           : Builtin(order);
+  }
+#endif
+
+  T value_;
+};
+
+// Standalone fence, e.g. to order a relaxed store before a relaxed load (Dekker).
+inline void AtomicFence(MemoryOrder order = MemoryOrder::kSeqCst) noexcept {
+#if defined(__ATOMIC_RELAXED)
+  switch (order) {
+    case MemoryOrder::kRelaxed:
+      break;
+    case MemoryOrder::kAcquire:
+      __atomic_thread_fence(__ATOMIC_ACQUIRE);
+      break;
+    case MemoryOrder::kRelease:
+      __atomic_thread_fence(__ATOMIC_RELEASE);
+      break;
+    case MemoryOrder::kAcqRel:
+      __atomic_thread_fence(__ATOMIC_ACQ_REL);
+      break;
+    case MemoryOrder::kSeqCst:
+      __atomic_thread_fence(__ATOMIC_SEQ_CST);
+      break;
+  }
+#else
+  if (order != MemoryOrder::kRelaxed) __sync_synchronize();
+#endif
+}
+
+#endif  // ATOMIC_H_
@@ -0,0 +1,125 @@
+// Cost of each memory order for Atomic<T> operations, uncontended and with every thread hammering
+// the same variable. On x86 loads of any order and non-seq_cst stores are plain movs, a seq_cst
+// store is an xchg, and every read-modify-write is a locked instruction whatever its order.
+//   g++ -std=c++17 -O2 -pthread atomic_bench.cc -o atomic_bench
+//   ./atomic_bench [operations per thread]
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "atomic.h"
+
+enum class Op { kLoad, kStore, kExchange, kFetchAdd, kCompareExchange };
+
+static const char* OpName(Op op) {
+  switch (op) {
+    case Op::kLoad:
+      return "Load";
+    case Op::kStore:
+      return "Store";
+    case Op::kExchange:
+      return "Exchange";
+    case Op::kFetchAdd:
+      return "FetchAdd";
+    case Op::kCompareExchange:
+      return "CompareExchange";
+  }
+  return "";
+}
+
+static const char* OrderName(MemoryOrder order) {
+  switch (order) {
+    case MemoryOrder::kRelaxed:
+      return "relaxed";
+    case MemoryOrder::kAcquire:
+      return "acquire";
+    case MemoryOrder::kRelease:
+      return "release";
+    case MemoryOrder::kAcqRel:
+      return "acq_rel";
+    case MemoryOrder::kSeqCst:
+      return "seq_cst";
+  }
+  return "";
+}
+
+// The order is a template argument so that each loop is compiled with a constant order.
+template <Op op, MemoryOrder order>
+void Loop(Atomic<uint64_t>& var, size_t nops) {
+  uint64_t sink = 0;
+  for (size_t i = 0; i < nops; ++i) {
+    if (op == Op::kLoad) {
+      sink += var.Load(order);
+    } else if (op == Op::kStore) {
+      var.Store(i, order);
+    } else if (op == Op::kExchange) {
+      sink += var.Exchange(i, order);
+    } else if (op == Op::kFetchAdd) {
+      sink += var.FetchAdd(1, order);
+    } else {
+      uint64_t expected = i;
+      sink += var.CompareExchange(expected, i + 1, order);
+    }
+  }
+  // keep the loads alive
+  asm volatile("" : : "r"(sink));
+}
+
+template <Op op, MemoryOrder order>
+void Run(size_t nthreads, size_t nops) {
+  alignas(64) Atomic<uint64_t> var(0);
+  auto start = std::chrono::steady_clock::now();
+
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < nthreads; ++i) {
+    threads.emplace_back([&var, nops] { Loop<op, order>(var, nops); });
+  }
+  for (auto& t : threads) t.join();
+
+  double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start)
+                  .count();
+  printf("%-16s %-8s %8zu %10.2f\n", OpName(op), OrderName(order), nthreads, ns / nops);
+}
+
+template <Op op>
+void RunLoad(size_t nthreads, size_t nops) {
+  Run<op, MemoryOrder::kRelaxed>(nthreads, nops);
+  Run<op, MemoryOrder::kAcquire>(nthreads, nops);
+  Run<op, MemoryOrder::kSeqCst>(nthreads, nops);
+}
+
+template <Op op>
+void RunStore(size_t nthreads, size_t nops) {
+  Run<op, MemoryOrder::kRelaxed>(nthreads, nops);
+  Run<op, MemoryOrder::kRelease>(nthreads, nops);
+  Run<op, MemoryOrder::kSeqCst>(nthreads, nops);
+}
+
+template <Op op>
+void RunRmw(size_t nthreads, size_t nops) {
+  Run<op, MemoryOrder::kRelaxed>(nthreads, nops);
+  Run<op, MemoryOrder::kAcquire>(nthreads, nops);
+  Run<op, MemoryOrder::kRelease>(nthreads, nops);
+  Run<op, MemoryOrder::kAcqRel>(nthreads, nops);
+  Run<op, MemoryOrder::kSeqCst>(nthreads, nops);
+}
+
+int main(int argc, char* argv[]) {
+  size_t nops = argc > 1 ? strtoul(argv[1], nullptr, 10) : 10000000;
+  size_t ncpus = std::thread::hardware_concurrency();
+
+  printf("%-16s %-8s %8s %10s\n", "op", "order", "threads", "ns/op");
+  for (size_t nthreads = 1; nthreads <= ncpus; nthreads = nthreads < ncpus ? ncpus : ncpus + 1) {
+    RunLoad<Op::kLoad>(nthreads, nops);
+    RunStore<Op::kStore>(nthreads, nops);
+    RunRmw<Op::kExchange>(nthreads, nops);
+    RunRmw<Op::kFetchAdd>(nthreads, nops);
+    RunRmw<Op::kCompareExchange>(nthreads, nops);
+  }
+
+  return 0;
+}
@@ -0,0 +1,84 @@
+#include "atomic.h"
+
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+void TestSingleThread() {
+  Atomic<int> a(1);
+  assert(a.Load() == 1);
+  a.Store(2, MemoryOrder::kRelease);
+  assert(a.Load(MemoryOrder::kAcquire) == 2);
+  assert(a.Exchange(3) == 2);
+  assert(a.FetchAdd(2) == 3);
+  assert(a.FetchSub(1) == 5);
+  assert(a.FetchOr(0x10) == 4);
+  assert(a.FetchAnd(0x10) == 0x14);
+  assert(a.Load(MemoryOrder::kRelaxed) == 0x10);
+
+  int expected = 0;
+  assert(!a.CompareExchange(expected, 1));
+  assert(expected == 0x10);
+  assert(a.CompareExchange(expected, 1, MemoryOrder::kAcqRel));
+  assert(a.Load() == 1);
+
+  // orders that do not fit a load or a store keep the part that applies
+  a.Store(5, MemoryOrder::kAcquire);
+  assert(a.Load(MemoryOrder::kRelease) == 5);
+  a.Store(6, MemoryOrder::kAcqRel);
+  assert(a.Load(MemoryOrder::kAcqRel) == 6);
+
+  int x = 0, y = 0;
+  Atomic<int*> p(&x);
+  assert(p.Exchange(&y) == &x);
+  int* old = &y;
+  while (!p.CompareExchangeWeak(old, &x, MemoryOrder::kRelease)) {
+  }
+  assert(p.Load() == &x);
+}
+
+void TestMessagePassing() {
+  // a release store publishes the plain writes before it to an acquire load that reads it
+  for (int round = 0; round < 1000; ++round) {
+    int data = 0;
+    Atomic<bool> ready(false);
+    std::thread producer([&data, &ready] {
+      data = 42;
+      ready.Store(true, MemoryOrder::kRelease);
+    });
+    while (!ready.Load(MemoryOrder::kAcquire)) {
+    }
+    assert(data == 42);
+    producer.join();
+  }
+}
+
+void TestCasCounter() {
+  const int kThreads = 4;
+  const int kIncrs = 100000;
+  Atomic<int64_t> counter(0);
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kThreads; ++i) {
+    threads.emplace_back([&counter, kIncrs] {
+      for (int j = 0; j < kIncrs; ++j) {
+        int64_t old = counter.Load(MemoryOrder::kRelaxed);
+        while (!counter.CompareExchangeWeak(old, old + 1, MemoryOrder::kRelaxed)) {
+        }
+      }
+    });
+  }
+  for (auto& t : threads) t.join();
+
+  assert(counter.Load() == kThreads * kIncrs);
+}
+
+int main() {
+  TestSingleThread();
+  TestMessagePassing();
+  TestCasCounter();
+  std::cout << "OK" << std::endl;
+  return 0;
+}
@@ -46,25 +46,36 @@
     } while (0)
 
 // using pthread mutex
+// The lock can be replaced, e.g. with the lighter FutexMutex from futex_mutex.h:
+//  #define ATOMIC_VAR_LOCK(mutex) (mutex).Lock()
+//  #define ATOMIC_VAR_UNLOCK(mutex) (mutex).Unlock()
 #else
 
+#  if defined(ATOMIC_VAR_LOCK) != defined(ATOMIC_VAR_UNLOCK)
+#    error "define both ATOMIC_VAR_LOCK and ATOMIC_VAR_UNLOCK, or neither"
+#  endif
+#  ifndef ATOMIC_VAR_LOCK
+#    define ATOMIC_VAR_LOCK(mutex) pthread_mutex_lock(&mutex)
+#    define ATOMIC_VAR_UNLOCK(mutex) pthread_mutex_unlock(&mutex)
+#  endif
+
 #  define ATOMIC_INCR(var, count, mutex) \
     do {                                 \
-      pthread_mutex_lock(&mutex);        \
+      ATOMIC_VAR_LOCK(mutex);            \
       var += (count);                    \
-      pthread_mutex_unlock(&mutex);      \
+      ATOMIC_VAR_UNLOCK(mutex);          \
     } while (0)
 #  define ATOMIC_DECR(var, count, mutex) \
     do {                                 \
-      pthread_mutex_lock(&mutex);        \
+      ATOMIC_VAR_LOCK(mutex);            \
       var -= (count);                    \
-      pthread_mutex_unlock(&mutex);      \
+      ATOMIC_VAR_UNLOCK(mutex);          \
     } while (0)
 #  define ATOMIC_GET(var, dstvar, mutex) \
     do {                                 \
-      pthread_mutex_lock(&mutex);        \
+      ATOMIC_VAR_LOCK(mutex);            \
       dstvar = var;                      \
-      pthread_mutex_unlock(&mutex);      \
+      ATOMIC_VAR_UNLOCK(mutex);          \
     } while (0)
 
 #endif
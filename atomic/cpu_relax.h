@@ -0,0 +1,13 @@
+#ifndef CPU_RELAX_H_
+#define CPU_RELAX_H_
+
+// Spin-wait hint: lets the sibling hyperthread run and saves power while busy waiting.
+static inline void CpuRelax() {
+#if defined(__i386) || defined(__amd64)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__)
+  asm volatile("yield");
+#endif
+}
+
+#endif  // CPU_RELAX_H_
@@ -0,0 +1,84 @@
+#ifndef FUTEX_MUTEX_H_
+#define FUTEX_MUTEX_H_
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cstdint>
+
+#include "cpu_relax.h"
+
+// Three-state futex mutex (Drepper, "Futexes Are Tricky"): 0 unlocked, 1 locked, 2 locked with
+// possible waiters. An uncontended Lock()/Unlock() pair is one CAS and one atomic decrement, with
+// no system call. Unlock() only enters the kernel when someone may be sleeping.
+//
+// Before sleeping, a contended Lock() spins for a while in case the owner is about to release.
+// Like glibc's adaptive mutex, the spin budget follows how long recent acquisitions actually had
+// to spin, capped at kMaxSpins, so short critical sections spin and long ones go to sleep.
+//
+// Process private, not recursive, no owner tracking.
+class FutexMutex {
+ public:
+  FutexMutex() = default;
+
+  FutexMutex(const FutexMutex& other) = delete;
+
+  FutexMutex& operator=(const FutexMutex& other) = delete;
+
+  void Lock() {
+    uint32_t c = 0;
+    if (__atomic_compare_exchange_n(&state_, &c, 1, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+      return;
+    }
+
+    int max_spins = 2 * __atomic_load_n(&spins_, __ATOMIC_RELAXED) + 10;
+    if (max_spins > kMaxSpins) max_spins = kMaxSpins;
+
+    for (int n = 1; n <= max_spins; ++n) {
+      CpuRelax();
+      c = 0;
+      if (__atomic_load_n(&state_, __ATOMIC_RELAXED) == 0 &&
+          __atomic_compare_exchange_n(&state_, &c, 1, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+        AdaptSpins(n);
+        return;
+      }
+    }
+    AdaptSpins(max_spins);
+
+    // Announce a waiter by setting 2. Whoever gets 0 back from the exchange owns the lock, and
+    // keeps state 2 because other waiters may still be asleep.
+    if (c != 2) c = __atomic_exchange_n(&state_, 2, __ATOMIC_ACQUIRE);
+    while (c != 0) {
+      syscall(SYS_futex, &state_, FUTEX_WAIT_PRIVATE, 2, nullptr, nullptr, 0);
+      c = __atomic_exchange_n(&state_, 2, __ATOMIC_ACQUIRE);
+    }
+  }
+
+  bool TryLock() {
+    uint32_t c = 0;
+    return __atomic_compare_exchange_n(&state_, &c, 1, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+  }
+
+  void Unlock() {
+    if (__atomic_fetch_sub(&state_, 1, __ATOMIC_RELEASE) != 1) {
+      // there may be waiters
+      __atomic_store_n(&state_, 0, __ATOMIC_RELEASE);
+      syscall(SYS_futex, &state_, FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+    }
+  }
+
+ private:
+  static constexpr int kMaxSpins = 100;
+
+  // moving average of the spins recent acquisitions needed
+  void AdaptSpins(int n) {
+    int spins = __atomic_load_n(&spins_, __ATOMIC_RELAXED);
+    __atomic_store_n(&spins_, spins + (n - spins) / 8, __ATOMIC_RELAXED);
+  }
+
+  uint32_t state_ = 0;
+  int spins_ = 0;
+};
+
+#endif  // FUTEX_MUTEX_H_
@@ -0,0 +1,37 @@
+#include "futex_mutex.h"
+
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+int main() {
+  FutexMutex lock;
+
+  assert(lock.TryLock());
+  assert(!lock.TryLock());
+  lock.Unlock();
+
+  const int kThreads = 8;
+  const int kIncrs = 100000;
+  // plain, only ever touched with the lock held
+  int64_t counter = 0;
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kThreads; ++i) {
+    threads.emplace_back([&lock, &counter, kIncrs] {
+      for (int j = 0; j < kIncrs; ++j) {
+        lock.Lock();
+        ++counter;
+        lock.Unlock();
+      }
+    });
+  }
+  for (auto& t : threads) t.join();
+
+  assert(counter == static_cast<int64_t>(kThreads) * kIncrs);
+
+  std::cout << "OK" << std::endl;
+  return 0;
+}
@@ -0,0 +1,74 @@
+#ifndef SEQLOCK_H_
+#define SEQLOCK_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "atomic.h"
+
+// Seqlock<T> -- read-mostly shared value with a single writer. Readers never write shared memory,
+// so they don't bounce a cache line between each other the way a mutex or rwlock does; they just
+// retry when a write raced with their copy. The writer never waits for readers.
+//
+// The sequence is odd while a write is in progress. A reader copies the value between two reads
+// of the sequence and keeps the copy only if both saw the same even number. The value is stored
+// as words accessed with relaxed atomics, so a torn read is a retry rather than a data race.
+//
+// Store() must not be called concurrently; serialize writers externally if there are several.
+template <typename T>
+class Seqlock {
+  static_assert(std::is_trivially_copyable<T>::value, "Seqlock<T> needs a trivially copyable T");
+
+ public:
+  Seqlock() : Seqlock(T()) {}
+
+  explicit Seqlock(const T& value) { Store(value); }
+
+  Seqlock(const Seqlock& other) = delete;
+
+  Seqlock& operator=(const Seqlock& other) = delete;
+
+  T Load() const {
+    uint64_t buf[kWords];
+    uint64_t seq;
+
+    while (true) {
+      seq = seq_.Load(MemoryOrder::kAcquire);
+      if (seq & 1) continue;
+
+      for (size_t i = 0; i < kWords; ++i) buf[i] = words_[i].Load(MemoryOrder::kRelaxed);
+      // keeps the copy above from moving below the second read of the sequence
+      AtomicFence(MemoryOrder::kAcquire);
+
+      if (seq_.Load(MemoryOrder::kRelaxed) == seq) break;
+    }
+
+    T value;
+    memcpy(&value, buf, sizeof(T));
+    return value;
+  }
+
+  void Store(const T& value) {
+    uint64_t buf[kWords] = {};
+    memcpy(buf, &value, sizeof(T));
+
+    uint64_t seq = seq_.Load(MemoryOrder::kRelaxed);
+    seq_.Store(seq + 1, MemoryOrder::kRelaxed);
+    // keeps the writes below from moving above the odd sequence
+    AtomicFence(MemoryOrder::kRelease);
+
+    for (size_t i = 0; i < kWords; ++i) words_[i].Store(buf[i], MemoryOrder::kRelaxed);
+
+    seq_.Store(seq + 2, MemoryOrder::kRelease);
+  }
+
+ private:
+  static constexpr size_t kWords = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+  Atomic<uint64_t> seq_{0};
+  Atomic<uint64_t> words_[kWords];
+};
+
+#endif  // SEQLOCK_H_
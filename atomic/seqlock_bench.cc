@@ -0,0 +1,112 @@
+// Read throughput of a shared struct with one writer updating it, as the number of readers grows:
+// Seqlock against pthread_mutex and pthread_rwlock.
+//   g++ -std=c++17 -O2 -pthread seqlock_bench.cc -o seqlock_bench
+//   ./seqlock_bench [milliseconds per run]
+
+#include <pthread.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "seqlock.h"
+
+struct Stats {
+  uint64_t values[8];
+};
+
+class MutexStats {
+ public:
+  Stats Load() {
+    pthread_mutex_lock(&mutex_);
+    Stats stats = stats_;
+    pthread_mutex_unlock(&mutex_);
+    return stats;
+  }
+
+  void Store(const Stats& stats) {
+    pthread_mutex_lock(&mutex_);
+    stats_ = stats;
+    pthread_mutex_unlock(&mutex_);
+  }
+
+ private:
+  pthread_mutex_t mutex_ = PTHREAD_MUTEX_INITIALIZER;
+  Stats stats_ = {};
+};
+
+class RwlockStats {
+ public:
+  Stats Load() {
+    pthread_rwlock_rdlock(&rwlock_);
+    Stats stats = stats_;
+    pthread_rwlock_unlock(&rwlock_);
+    return stats;
+  }
+
+  void Store(const Stats& stats) {
+    pthread_rwlock_wrlock(&rwlock_);
+    stats_ = stats;
+    pthread_rwlock_unlock(&rwlock_);
+  }
+
+ private:
+  pthread_rwlock_t rwlock_ = PTHREAD_RWLOCK_INITIALIZER;
+  Stats stats_ = {};
+};
+
+template <typename Shared>
+void Run(const char* name, size_t nreaders, int millis) {
+  Shared shared;
+  Atomic<bool> done(false);
+  std::vector<uint64_t> reads(nreaders, 0);
+
+  std::vector<std::thread> readers;
+  for (size_t i = 0; i < nreaders; ++i) {
+    readers.emplace_back([&shared, &done, &reads, i] {
+      uint64_t n = 0, sink = 0;
+      while (!done.Load(MemoryOrder::kRelaxed)) {
+        sink += shared.Load().values[0];
+        ++n;
+      }
+      asm volatile("" : : "r"(sink));
+      reads[i] = n;
+    });
+  }
+
+  // the writer publishes about once every 10us
+  std::thread writer([&shared, &done] {
+    Stats stats = {};
+    while (!done.Load(MemoryOrder::kRelaxed)) {
+      for (uint64_t& value : stats.values) ++value;
+      shared.Store(stats);
+      std::this_thread::sleep_for(std::chrono::microseconds(10));
+    }
+  });
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(millis));
+  done.Store(true);
+  for (auto& t : readers) t.join();
+  writer.join();
+
+  uint64_t total = 0;
+  for (uint64_t n : reads) total += n;
+  printf("%-8s %8zu %14.2f\n", name, nreaders, total / (millis * 1e3));
+}
+
+int main(int argc, char* argv[]) {
+  int millis = argc > 1 ? atoi(argv[1]) : 1000;
+  size_t ncpus = std::thread::hardware_concurrency();
+
+  printf("%-8s %8s %14s\n", "lock", "readers", "Mreads/s");
+  for (size_t nreaders = 1; nreaders <= ncpus; nreaders *= 2) {
+    Run<Seqlock<Stats>>("seqlock", nreaders, millis);
+    Run<RwlockStats>("rwlock", nreaders, millis);
+    Run<MutexStats>("mutex", nreaders, millis);
+  }
+
+  return 0;
+}
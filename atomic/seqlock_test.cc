@@ -0,0 +1,48 @@
+#include "seqlock.h"
+
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+struct Config {
+  uint64_t version;
+  uint32_t fields[13];
+};
+
+int main() {
+  Seqlock<Config> config;
+  assert(config.Load().version == 0);
+
+  const uint64_t kVersions = 200000;
+  Atomic<bool> done(false);
+
+  std::vector<std::thread> readers;
+  for (int i = 0; i < 3; ++i) {
+    readers.emplace_back([&config, &done] {
+      uint64_t last = 0;
+      while (!done.Load(MemoryOrder::kAcquire)) {
+        Config c = config.Load();
+        // never a mix of two versions, and never going back in time
+        for (uint32_t field : c.fields) assert(field == static_cast<uint32_t>(c.version));
+        assert(c.version >= last);
+        last = c.version;
+      }
+    });
+  }
+
+  for (uint64_t v = 1; v <= kVersions; ++v) {
+    Config c;
+    c.version = v;
+    for (uint32_t& field : c.fields) field = static_cast<uint32_t>(v);
+    config.Store(c);
+  }
+  done.Store(true, MemoryOrder::kRelease);
+  for (auto& t : readers) t.join();
+
+  assert(config.Load().version == kVersions);
+
+  std::cout << "OK" << std::endl;
+  return 0;
+}
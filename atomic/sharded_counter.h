@@ -0,0 +1,71 @@
+#ifndef SHARDED_COUNTER_H_
+#define SHARDED_COUNTER_H_
+
+#include <sched.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "atomic.h"
+
+// Counter split into one cache-line-sized slot per CPU, so concurrent increments from different
+// cores touch different cache lines instead of bouncing one shared variable. Add() updates the
+// caller's slot with a relaxed Atomic<T>::FetchAdd(), Get() sums all slots. The sum is not a
+// snapshot: increments that race with Get() may or may not be included.
+//
+// A thread picks its slot once, round robin. Define SHARDED_COUNTER_PERCPU to pick the slot of
+// the CPU the thread is currently running on with sched_getcpu() instead, which suits pools of
+// threads larger than the number of cores.
+class ShardedCounter {
+ public:
+  ShardedCounter() {
+    long ncpus = sysconf(_SC_NPROCESSORS_CONF);
+    nslots_ = 1;
+    while (nslots_ < static_cast<size_t>(ncpus > 0 ? ncpus : 1)) nslots_ <<= 1;
+    slots_.reset(new Slot[nslots_]);
+  }
+
+  ShardedCounter(const ShardedCounter& other) = delete;
+
+  ~ShardedCounter() {}
+
+  ShardedCounter& operator=(const ShardedCounter& other) = delete;
+
+  void Add(int64_t count) {
+    slots_[SlotIndex() & (nslots_ - 1)].value.FetchAdd(count, MemoryOrder::kRelaxed);
+  }
+
+  void Incr() { Add(1); }
+
+  void Decr() { Add(-1); }
+
+  int64_t Get() {
+    int64_t sum = 0;
+    for (size_t i = 0; i < nslots_; ++i) sum += slots_[i].value.Load(MemoryOrder::kRelaxed);
+    return sum;
+  }
+
+ private:
+  struct alignas(64) Slot {
+    Atomic<int64_t> value{0};
+  };
+
+  static size_t SlotIndex() {
+#ifdef SHARDED_COUNTER_PERCPU
+    int cpu = sched_getcpu();
+    return cpu >= 0 ? static_cast<size_t>(cpu) : 0;
+#else
+    static std::atomic<size_t> next{0};
+    thread_local size_t index = next.fetch_add(1, std::memory_order_relaxed);
+    return index;
+#endif
+  }
+
+  size_t nslots_;
+  std::unique_ptr<Slot[]> slots_;
+};
+
+#endif  // SHARDED_COUNTER_H_
@@ -0,0 +1,84 @@
+// Contended increments: the three backends of atomic_var.h (each spelled out here, since the
+// macros pick one at compile time) against ShardedCounter.
+//   g++ -std=c++17 -O2 -pthread sharded_counter_bench.cc -o sharded_counter_bench
+//   ./sharded_counter_bench [increments per thread]
+
+#include <pthread.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "sharded_counter.h"
+
+struct AtomicBuiltinCounter {
+  void Incr() { __atomic_add_fetch(&value, 1, __ATOMIC_RELAXED); }
+  int64_t Get() { return __atomic_load_n(&value, __ATOMIC_RELAXED); }
+
+  int64_t value = 0;
+};
+
+struct SyncBuiltinCounter {
+  void Incr() { __sync_add_and_fetch(&value, 1); }
+  int64_t Get() { return __sync_sub_and_fetch(&value, 0); }
+
+  int64_t value = 0;
+};
+
+struct MutexCounter {
+  void Incr() {
+    pthread_mutex_lock(&mutex);
+    ++value;
+    pthread_mutex_unlock(&mutex);
+  }
+  int64_t Get() {
+    pthread_mutex_lock(&mutex);
+    int64_t v = value;
+    pthread_mutex_unlock(&mutex);
+    return v;
+  }
+
+  int64_t value = 0;
+  pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+};
+
+template <typename Counter>
+void Run(const char* name, size_t nthreads, size_t nincrs) {
+  Counter counter;
+  auto start = std::chrono::steady_clock::now();
+
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < nthreads; ++i) {
+    threads.emplace_back([&counter, nincrs] {
+      for (size_t j = 0; j < nincrs; ++j) counter.Incr();
+    });
+  }
+  for (auto& t : threads) t.join();
+
+  double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start)
+                  .count();
+  if (counter.Get() != static_cast<int64_t>(nthreads * nincrs)) {
+    printf("%s: wrong count\n", name);
+    exit(1);
+  }
+  printf("%-10s %8zu %12.2f %12.2f\n", name, nthreads, nthreads * nincrs / ns * 1e3,
+         ns / nincrs);
+}
+
+int main(int argc, char* argv[]) {
+  size_t nincrs = argc > 1 ? strtoul(argv[1], nullptr, 10) : 10000000;
+  size_t ncpus = std::thread::hardware_concurrency();
+
+  printf("%-10s %8s %12s %12s\n", "backend", "threads", "Mincr/s", "ns/incr");
+  for (size_t nthreads = 1; nthreads <= 2 * ncpus; nthreads *= 2) {
+    Run<AtomicBuiltinCounter>("__atomic", nthreads, nincrs);
+    Run<SyncBuiltinCounter>("__sync", nthreads, nincrs);
+    Run<MutexCounter>("mutex", nthreads, nincrs);
+    Run<ShardedCounter>("sharded", nthreads, nincrs);
+  }
+
+  return 0;
+}
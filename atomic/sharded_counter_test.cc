@@ -0,0 +1,31 @@
+#include "sharded_counter.h"
+
+#include <cassert>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+int main() {
+  ShardedCounter counter;
+  assert(counter.Get() == 0);
+
+  counter.Incr();
+  counter.Add(41);
+  counter.Decr();
+  assert(counter.Get() == 41);
+
+  const int kThreads = 8;
+  const int kIncrs = 1000000;
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kThreads; ++i) {
+    threads.emplace_back([&counter, kIncrs] {
+      for (int j = 0; j < kIncrs; ++j) counter.Incr();
+    });
+  }
+  for (auto& t : threads) t.join();
+
+  assert(counter.Get() == 41 + static_cast<int64_t>(kThreads) * kIncrs);
+
+  std::cout << "OK" << std::endl;
+  return 0;
+}
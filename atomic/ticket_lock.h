@@ -0,0 +1,54 @@
+#ifndef TICKET_LOCK_H_
+#define TICKET_LOCK_H_
+
+#include <cstdint>
+#include <thread>
+
+#include "atomic.h"
+#include "cpu_relax.h"
+
+// FIFO spin lock: each Lock() takes the next ticket and waits until it is served, so the lock is
+// granted strictly in arrival order and no thread starves. Use it for short, fairness-sensitive
+// critical sections. Only the next waiter in line spins; the others yield the CPU, so an
+// oversubscribed machine still makes progress.
+class TicketLock {
+ public:
+  TicketLock() = default;
+
+  TicketLock(const TicketLock& other) = delete;
+
+  TicketLock& operator=(const TicketLock& other) = delete;
+
+  void Lock() {
+    uint32_t ticket = next_.FetchAdd(1, MemoryOrder::kRelaxed);
+    for (uint32_t n = 1;; ++n) {
+      uint32_t serving = serving_.Load(MemoryOrder::kAcquire);
+      if (serving == ticket) return;
+
+      // only the next in line spins, whoever is further back gives up the CPU
+      if (ticket - serving > 1 || n % kSpinsPerYield == 0)
+        std::this_thread::yield();
+      else
+        CpuRelax();
+    }
+  }
+
+  bool TryLock() {
+    uint32_t ticket = serving_.Load(MemoryOrder::kAcquire);
+    uint32_t next = ticket;
+    return next_.CompareExchange(next, ticket + 1, MemoryOrder::kAcquire);
+  }
+
+  // only the owner writes serving_, so a load and a store are enough
+  void Unlock() {
+    serving_.Store(serving_.Load(MemoryOrder::kRelaxed) + 1, MemoryOrder::kRelease);
+  }
+
+ private:
+  static constexpr uint32_t kSpinsPerYield = 1024;
+
+  Atomic<uint32_t> next_{0};
+  Atomic<uint32_t> serving_{0};
+};
+
+#endif  // TICKET_LOCK_H_
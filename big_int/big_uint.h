@@ -1,7 +1,9 @@
 #ifndef BIG_UINI_H_
 #define BIG_UINI_H_
 
+#include <algorithm>
 #include <cassert>
+#include <cstddef>
 #include <cstdint>
 #include <iomanip>
 #include <ostream>
@@ -33,7 +35,7 @@ class BigUint {
     auto& other = right.data_;
     auto n = std::max(data_.size(), other.size());
     sum.data_.reserve(n + 1);
-    for (auto i = 0; i < n; ++i) {
+    for (size_t i = 0; i < n; ++i) {
       T a = i < data_.size() ? data_[i] : 0;
       T b = i < other.size() ? other[i] : 0;
       sum.data_.push_back((a + b + carry) % m);
@@ -47,8 +49,8 @@ class BigUint {
     BigUint product;
     auto& other = right.data_;
     product.data_.resize(data_.size() + other.size());
-    for (auto i = 0; i < other.size(); ++i) {
-      for (auto j = 0; j < data_.size(); ++j) {
+    for (size_t i = 0; i < other.size(); ++i) {
+      for (size_t j = 0; j < data_.size(); ++j) {
         T lo = (other[i] * data_[j] + product.data_[i + j]) % m;
         T hi = (other[i] * data_[j] + product.data_[i + j]) / m;
         product.data_[i + j] = lo;
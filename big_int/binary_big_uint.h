@@ -0,0 +1,335 @@
+#ifndef BINARY_BIG_UINT_H_
+#define BINARY_BIG_UINT_H_
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <ostream>
+#include <vector>
+
+// BigUint with full 64-bit limbs, least significant first, in place of base 10^9 digits. A limb
+// holds 19.3 decimal digits instead of 9, so a number has 2.1 times fewer limbs and a schoolbook
+// product 4.6 times fewer limb products, each a single 64x64->128 multiply with the carry in the
+// high half instead of a % and / by 10^9. Zero has no limbs.
+//
+// Products of larger numbers use Karatsuba, O(n^1.58), and Toom-3, O(n^1.46), both recursing
+// down to schoolbook. Where each one takes over is set by binary_internal::Thresholds.
+//
+// Decimal digits are only computed by operator<<, which divides by 10^19 repeatedly and is
+// quadratic in the number of limbs.
+
+namespace binary_internal {
+
+using Limb = std::uint64_t;
+using DoubleLimb = unsigned __int128;
+
+// out[0, na + nb) = a[0, na) * b[0, nb); out must not overlap a or b
+inline void MulSchoolbook(const Limb* a, size_t na, const Limb* b, size_t nb, Limb* out) {
+  std::fill(out, out + na + nb, 0);
+  for (size_t i = 0; i < nb; ++i) {
+    // (2^64 - 1)^2 + 2 * (2^64 - 1) = 2^128 - 1, so t cannot overflow
+    Limb carry = 0;
+    for (size_t j = 0; j < na; ++j) {
+      DoubleLimb t = static_cast<DoubleLimb>(a[j]) * b[i] + out[i + j] + carry;
+      out[i + j] = static_cast<Limb>(t);
+      carry = static_cast<Limb>(t >> 64);
+    }
+    out[i + na] = carry;
+  }
+}
+
+using Limbs = std::vector<Limb>;
+
+// Operands with fewer limbs than these in the smaller one use the simpler algorithm. Karatsuba
+// needs 4 limbs or more to make progress. The defaults are tuning values, not measured
+// crossovers: the best ones depend on the CPU, its caches and the compiler, so rerun
+// binary_big_uint_mul_bench on the target machine and set them from what it reports.
+struct Thresholds {
+  size_t karatsuba = 32;
+  size_t toom3 = 240;
+};
+
+// out += x << (64 * offset); the sum must fit in out
+inline void AddTo(Limbs& out, size_t offset, const Limb* x, size_t nx) {
+  while (nx > 0 && x[nx - 1] == 0) --nx;
+  Limb carry = 0;
+  size_t i = 0;
+  for (; i < nx; ++i) {
+    DoubleLimb t = static_cast<DoubleLimb>(out[offset + i]) + x[i] + carry;
+    out[offset + i] = static_cast<Limb>(t);
+    carry = static_cast<Limb>(t >> 64);
+  }
+  for (; carry; ++i) carry = ++out[offset + i] == 0;
+}
+
+// x -= y; x must not be less than y
+inline void SubFrom(Limbs& x, const Limbs& y) {
+  size_t ny = y.size();
+  while (ny > 0 && y[ny - 1] == 0) --ny;
+  Limb borrow = 0;
+  size_t i = 0;
+  for (; i < ny; ++i) {
+    DoubleLimb t = static_cast<DoubleLimb>(x[i]) - y[i] - borrow;
+    x[i] = static_cast<Limb>(t);
+    borrow = static_cast<Limb>(t >> 64) & 1;
+  }
+  for (; borrow; ++i) borrow = x[i]-- == 0;
+}
+
+inline Limbs Add(const Limb* a, size_t na, const Limb* b, size_t nb) {
+  Limbs sum(std::max(na, nb) + 1);
+  std::copy(a, a + na, sum.begin());
+  AddTo(sum, 0, b, nb);
+  return sum;
+}
+
+inline void Trim(Limbs& x) {
+  while (!x.empty() && x.back() == 0) x.pop_back();
+}
+
+inline int Compare(const Limbs& x, const Limbs& y) {
+  if (x.size() != y.size()) return x.size() < y.size() ? -1 : 1;
+  for (size_t i = x.size(); i-- > 0;) {
+    if (x[i] != y[i]) return x[i] < y[i] ? -1 : 1;
+  }
+  return 0;
+}
+
+// Toom-3 intermediate: a magnitude, trimmed, and a sign
+struct Signed {
+  Limbs magnitude;
+  bool negative = false;
+};
+
+inline Signed Add(const Signed& x, const Signed& y) {
+  if (x.negative == y.negative) {
+    Signed sum{Add(x.magnitude.data(), x.magnitude.size(), y.magnitude.data(),
+                   y.magnitude.size()),
+               x.negative};
+    Trim(sum.magnitude);
+    return sum;
+  }
+  bool x_smaller = Compare(x.magnitude, y.magnitude) < 0;
+  Signed difference = x_smaller ? y : x;
+  SubFrom(difference.magnitude, x_smaller ? x.magnitude : y.magnitude);
+  Trim(difference.magnitude);
+  if (difference.magnitude.empty()) difference.negative = false;
+  return difference;
+}
+
+inline Signed Sub(const Signed& x, Signed y) {
+  if (!y.magnitude.empty()) y.negative = !y.negative;
+  return Add(x, y);
+}
+
+// x / d, where d divides x
+inline Signed DivExact(Signed x, Limb d) {
+  Limb remainder = 0;
+  for (size_t i = x.magnitude.size(); i-- > 0;) {
+    DoubleLimb t = static_cast<DoubleLimb>(remainder) << 64 | x.magnitude[i];
+    x.magnitude[i] = static_cast<Limb>(t / d);
+    remainder = static_cast<Limb>(t % d);
+  }
+  assert(remainder == 0);
+  Trim(x.magnitude);
+  return x;
+}
+
+inline Signed Part(const Limb* a, size_t begin, size_t end) {
+  Signed part{Limbs(a + begin, a + end)};
+  Trim(part.magnitude);
+  return part;
+}
+
+inline Limbs Multiply(const Limb* a, size_t na, const Limb* b, size_t nb,
+                      const Thresholds& thresholds = Thresholds());
+
+inline Signed Multiply(const Signed& x, const Signed& y, const Thresholds& thresholds) {
+  Signed product{Multiply(x.magnitude.data(), x.magnitude.size(), y.magnitude.data(),
+                          y.magnitude.size(), thresholds),
+                 x.negative != y.negative};
+  Trim(product.magnitude);
+  if (product.magnitude.empty()) product.negative = false;
+  return product;
+}
+
+// a = a1 * B^h + a0, b = b1 * B^h + b0, with B = 2^64 and h = ceil(na / 2) < nb <= na:
+// a * b = z2 * B^2h + z1 * B^h + z0, where z0 = a0 * b0, z2 = a1 * b1 and
+// z1 = (a0 + a1) * (b0 + b1) - z0 - z2, three half-size products instead of four.
+inline Limbs MulKaratsuba(const Limb* a, size_t na, const Limb* b, size_t nb,
+                          const Thresholds& thresholds) {
+  size_t h = (na + 1) / 2;
+  Limbs z0 = Multiply(a, h, b, h, thresholds);
+  Limbs z2 = Multiply(a + h, na - h, b + h, nb - h, thresholds);
+  Limbs a01 = Add(a, h, a + h, na - h);
+  Limbs b01 = Add(b, h, b + h, nb - h);
+  Trim(a01);
+  Trim(b01);
+  Limbs z1 = Multiply(a01.data(), a01.size(), b01.data(), b01.size(), thresholds);
+  SubFrom(z1, z0);
+  SubFrom(z1, z2);
+
+  Limbs out(na + nb);
+  std::copy(z0.begin(), z0.end(), out.begin());
+  std::copy(z2.begin(), z2.end(), out.begin() + 2 * h);
+  AddTo(out, h, z1.data(), z1.size());
+  return out;
+}
+
+// Splits both operands into three parts of k = ceil(na / 3) limbs, a(x) = a2 x^2 + a1 x + a0
+// at x = B^k, with 2k < nb <= na. a * b is the degree 4 polynomial through the products of a(x)
+// and b(x) at 0, 1, -1, -2 and infinity, five third-size products instead of nine,
+// interpolated with Bodrato's sequence.
+inline Limbs MulToom3(const Limb* a, size_t na, const Limb* b, size_t nb,
+                      const Thresholds& thresholds) {
+  size_t k = (na + 2) / 3;
+
+  // a(0), a(1), a(-1), a(-2), a(infinity)
+  auto evaluate = [k](const Limb* a, size_t na, Signed values[5]) {
+    Signed a0 = Part(a, 0, k);
+    Signed a1 = Part(a, k, 2 * k);
+    Signed a2 = Part(a, 2 * k, na);
+    Signed a02 = Add(a0, a2);
+    values[0] = a0;
+    values[1] = Add(a02, a1);
+    values[2] = Sub(a02, a1);
+    Signed t = Add(values[2], a2);
+    values[3] = Sub(Add(t, t), a0);
+    values[4] = a2;
+  };
+  Signed va[5], vb[5];
+  evaluate(a, na, va);
+  evaluate(b, nb, vb);
+
+  Signed r0 = Multiply(va[0], vb[0], thresholds);
+  Signed r1 = Multiply(va[1], vb[1], thresholds);
+  Signed rm1 = Multiply(va[2], vb[2], thresholds);
+  Signed rm2 = Multiply(va[3], vb[3], thresholds);
+  Signed rinf = Multiply(va[4], vb[4], thresholds);
+
+  Signed r3 = DivExact(Sub(rm2, r1), 3);
+  r1 = DivExact(Sub(r1, rm1), 2);
+  Signed r2 = Sub(rm1, r0);
+  r3 = Add(DivExact(Sub(r2, r3), 2), Add(rinf, rinf));
+  r2 = Sub(Add(r2, r1), rinf);
+  r1 = Sub(r1, r3);
+
+  Limbs out(na + nb);
+  const Signed* coefficients[] = {&r0, &r1, &r2, &r3, &rinf};
+  for (size_t i = 0; i < 5; ++i) {
+    assert(!coefficients[i]->negative);
+    AddTo(out, i * k, coefficients[i]->magnitude.data(), coefficients[i]->magnitude.size());
+  }
+  return out;
+}
+
+// a[0, na) * b[0, nb), na + nb limbs
+inline Limbs Multiply(const Limb* a, size_t na, const Limb* b, size_t nb,
+                      const Thresholds& thresholds) {
+  assert(thresholds.karatsuba >= 4);
+  if (na < nb) {
+    std::swap(a, b);
+    std::swap(na, nb);
+  }
+  if (nb < thresholds.karatsuba) {
+    Limbs out(na + nb);
+    MulSchoolbook(a, na, b, nb, out.data());
+    return out;
+  }
+  if (nb <= (na + 1) / 2) {
+    // too unbalanced to split both: a0 * b + a1 * b * B^h
+    size_t h = (na + 1) / 2;
+    Limbs out = Multiply(a, h, b, nb, thresholds);
+    out.resize(na + nb);
+    Limbs high = Multiply(a + h, na - h, b, nb, thresholds);
+    AddTo(out, h, high.data(), high.size());
+    return out;
+  }
+  if (nb < thresholds.toom3 || nb <= 2 * ((na + 2) / 3)) {
+    return MulKaratsuba(a, na, b, nb, thresholds);
+  }
+  return MulToom3(a, na, b, nb, thresholds);
+}
+
+}  // namespace binary_internal
+
+class BinaryBigUint {
+  using Limb = binary_internal::Limb;
+  using DoubleLimb = binary_internal::DoubleLimb;
+
+  friend std::ostream& operator<<(std::ostream& os, const BinaryBigUint& n) {
+    // 10^19 is the largest power of ten in a limb
+    const Limb kChunk = 10000000000000000000ULL;
+    const int kChunkDigits = 19;
+
+    std::vector<Limb> rest = n.data_;
+    std::vector<Limb> chunks;
+    while (!rest.empty()) {
+      Limb remainder = 0;
+      for (auto it = rest.rbegin(); it != rest.rend(); ++it) {
+        DoubleLimb t = static_cast<DoubleLimb>(remainder) << 64 | *it;
+        *it = static_cast<Limb>(t / kChunk);
+        remainder = static_cast<Limb>(t % kChunk);
+      }
+      chunks.push_back(remainder);
+      while (!rest.empty() && rest.back() == 0) rest.pop_back();
+    }
+
+    if (chunks.empty()) return os << 0;
+    auto it = chunks.rbegin();
+    os << *it++;
+    char fill = os.fill('0');
+    while (it != chunks.rend()) os << std::setw(kChunkDigits) << *it++;
+    os.fill(fill);
+    return os;
+  }
+
+ public:
+  BinaryBigUint() = default;
+
+  BinaryBigUint(std::uint64_t x) {
+    if (x) data_.push_back(x);
+  }
+
+  BinaryBigUint operator+(const BinaryBigUint& right) const {
+    const std::vector<Limb>& longer = data_.size() >= right.data_.size() ? data_ : right.data_;
+    const std::vector<Limb>& shorter = data_.size() >= right.data_.size() ? right.data_ : data_;
+    BinaryBigUint sum;
+    sum.data_.reserve(longer.size() + 1);
+    Limb carry = 0;
+    for (size_t i = 0; i < longer.size(); ++i) {
+      DoubleLimb t = static_cast<DoubleLimb>(longer[i]) + carry;
+      if (i < shorter.size()) t += shorter[i];
+      sum.data_.push_back(static_cast<Limb>(t));
+      carry = static_cast<Limb>(t >> 64);
+    }
+    if (carry > 0) sum.data_.push_back(carry);
+    return sum;
+  }
+
+  BinaryBigUint operator*(const BinaryBigUint& right) const {
+    BinaryBigUint product;
+    if (data_.empty() || right.data_.empty()) return product;
+    product.data_ = binary_internal::Multiply(data_.data(), data_.size(), right.data_.data(),
+                                              right.data_.size());
+    product.Trim();
+    return product;
+  }
+
+  bool operator==(const BinaryBigUint& right) const { return data_ == right.data_; }
+
+  bool operator!=(const BinaryBigUint& right) const { return data_ != right.data_; }
+
+  size_t Limbs() const { return data_.size(); }
+
+ private:
+  void Trim() {
+    while (!data_.empty() && data_.back() == 0) data_.pop_back();
+  }
+
+  std::vector<Limb> data_;
+};
+
+#endif  // BINARY_BIG_UINT_H_
@@ -0,0 +1,64 @@
+// Multiplying two numbers of the same number of decimal digits, in base 10^9 BigUint, which is
+// schoolbook only, and in 2^64 BinaryBigUint, which moves on to Karatsuba and Toom-3 from 32
+// limbs, and the cost of printing the BinaryBigUint product in decimal.
+//   g++ -std=c++17 -O2 binary_big_uint_bench.cc -o binary_big_uint_bench
+//   ./binary_big_uint_bench
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <sstream>
+
+#include "big_uint.h"
+#include "binary_big_uint.h"
+
+// a number of about 9 * steps decimal digits, the same in either representation
+template <typename N>
+N Make(int steps, uint64_t seed) {
+  N n(1);
+  for (int i = 0; i < steps; ++i) n = n * N(999999937) + N((seed + i) % 1000000000);
+  return n;
+}
+
+template <typename Fn>
+double NsPerCall(Fn fn) {
+  int calls = 0;
+  auto start = std::chrono::steady_clock::now();
+  double ns;
+  do {
+    fn();
+    ++calls;
+    ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start)
+             .count();
+  } while (ns < 2e8);
+  return ns / calls;
+}
+
+int main() {
+  printf("%10s %10s %10s %14s %14s %8s %14s\n", "digits", "10^9 limbs", "2^64 limbs", "BigUint ns",
+         "Binary ns", "speedup", "print ns");
+  for (int digits : {90, 900, 9000, 45000, 90000}) {
+    int steps = digits / 9;
+    auto a = Make<BigUint<>>(steps, 1);
+    auto b = Make<BigUint<>>(steps, 2);
+    auto c = Make<BinaryBigUint>(steps, 1);
+    auto d = Make<BinaryBigUint>(steps, 2);
+
+    double base_ns = NsPerCall([&] {
+      auto product = a * b;
+      asm volatile("" : : "r"(&product) : "memory");
+    });
+    double binary_ns = NsPerCall([&] {
+      auto product = c * d;
+      asm volatile("" : : "r"(&product) : "memory");
+    });
+    BinaryBigUint product = c * d;
+    double print_ns = NsPerCall([&] {
+      std::stringstream ss;
+      ss << product;
+    });
+    printf("%10d %10d %10zu %14.0f %14.0f %8.2f %14.0f\n", digits, steps, c.Limbs(), base_ns,
+           binary_ns, base_ns / binary_ns, print_ns);
+  }
+  return 0;
+}
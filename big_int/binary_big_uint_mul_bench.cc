@@ -0,0 +1,80 @@
+// Multiplying two BinaryBigUints of n limbs each, for n from 10 to 100000: schoolbook only,
+// Karatsuba down to schoolbook, and Toom-3 down to Karatsuba as operator* does. Then, to tune
+// binary_internal::Thresholds, the time of one product for a range of each threshold.
+//   g++ -std=c++17 -O2 -DNDEBUG binary_big_uint_mul_bench.cc -o binary_big_uint_mul_bench
+//   ./binary_big_uint_mul_bench
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+
+#include "binary_big_uint.h"
+
+using binary_internal::Limbs;
+using binary_internal::Thresholds;
+
+static Limbs Random(size_t n, uint64_t seed) {
+  std::mt19937_64 random(seed);
+  Limbs limbs(n);
+  for (uint64_t& limb : limbs) limb = random();
+  return limbs;
+}
+
+// a * b, the best of 5 runs of at least 40ms each, since this machine may be shared
+static double NsPerMultiply(const Limbs& a, const Limbs& b, const Thresholds& thresholds) {
+  double best = 0;
+  for (int run = 0; run < 5; ++run) {
+    int calls = 0;
+    auto start = std::chrono::steady_clock::now();
+    double ns;
+    do {
+      Limbs product =
+          binary_internal::Multiply(a.data(), a.size(), b.data(), b.size(), thresholds);
+      asm volatile("" : : "r"(product.data()) : "memory");
+      ++calls;
+      ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start)
+               .count();
+    } while (ns < 4e7);
+    if (run == 0 || ns / calls < best) best = ns / calls;
+  }
+  return best;
+}
+
+int main() {
+  const Thresholds kDefault;
+  const Thresholds kSchoolbook{SIZE_MAX, SIZE_MAX};
+  const Thresholds kKaratsuba{kDefault.karatsuba, SIZE_MAX};
+
+  printf("%8s %16s %16s %16s\n", "limbs", "schoolbook us", "Karatsuba us", "Toom-3 us");
+  for (size_t n : {10, 20, 30, 50, 100, 200, 300, 500, 1000, 2000, 5000, 10000, 20000, 50000,
+                   100000}) {
+    Limbs a = Random(n, 1);
+    Limbs b = Random(n, 2);
+    // schoolbook takes over a minute at 100000 limbs
+    if (n <= 20000) {
+      printf("%8zu %16.2f", n, NsPerMultiply(a, b, kSchoolbook) / 1000);
+    } else {
+      printf("%8zu %16s", n, "-");
+    }
+    printf(" %16.2f %16.2f\n", NsPerMultiply(a, b, kKaratsuba) / 1000,
+           NsPerMultiply(a, b, kDefault) / 1000);
+  }
+
+  printf("\n%8s %16s %16s\n", "limbs", "karatsuba at", "us");
+  for (size_t threshold : {8, 16, 24, 32, 48, 64, 96}) {
+    Limbs a = Random(1000, 1);
+    Limbs b = Random(1000, 2);
+    printf("%8d %16zu %16.2f\n", 1000, threshold,
+           NsPerMultiply(a, b, {threshold, SIZE_MAX}) / 1000);
+  }
+
+  printf("\n%8s %16s %16s\n", "limbs", "toom3 at", "us");
+  for (size_t threshold : {80, 120, 160, 240, 320, 480, 640}) {
+    Limbs a = Random(5000, 1);
+    Limbs b = Random(5000, 2);
+    printf("%8d %16zu %16.2f\n", 5000, threshold,
+           NsPerMultiply(a, b, {kDefault.karatsuba, threshold}) / 1000);
+  }
+  return 0;
+}
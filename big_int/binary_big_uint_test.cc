@@ -0,0 +1,83 @@
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+
+#include "big_uint.h"
+#include "binary_big_uint.h"
+
+template <typename N>
+std::string ToString(const N& n) {
+  std::stringstream ss;
+  ss << n;
+  return ss.str();
+}
+
+BinaryBigUint Factorial(int n) {
+  if (n == 1) return BinaryBigUint(1);
+  return BinaryBigUint(n) * Factorial(n - 1);
+}
+
+int main() {
+  std::string n2 =
+      "93326215443944152681699238856266700490715968264381621468592963895217599993229915608941463976"
+      "156518286253697920827223758251185210916864000000000000000000000000";
+  assert(ToString(Factorial(100)) == n2);
+
+  // carries across full limbs
+  assert(ToString(BinaryBigUint()) == "0");
+  assert(ToString(BinaryBigUint(5) * BinaryBigUint()) == "0");
+  BinaryBigUint max(UINT64_MAX);
+  assert(ToString(max + BinaryBigUint(1)) == "18446744073709551616");
+  assert(ToString(max * max) == "340282366920938463426481119284349108225");
+  assert((max * max + max + max + BinaryBigUint(1)).Limbs() == 3);
+  assert(ToString(BinaryBigUint(10000000000000000000ULL) * BinaryBigUint(10)) ==
+         "100000000000000000000");
+
+  // the same products in base 10^9
+  std::mt19937_64 random(1);
+  for (int round = 0; round < 20; ++round) {
+    BinaryBigUint a(1), b(1);
+    BigUint<> c(1), d(1);
+    for (int i = 0; i < round * 3 + 1; ++i) {
+      uint64_t x = random() % 1000000000;
+      uint64_t y = random() % 1000000000;
+      a = a * BinaryBigUint(x) + BinaryBigUint(y);
+      c = c * BigUint<>(x) + BigUint<>(y);
+      b = b * BinaryBigUint(y) + BinaryBigUint(x);
+      d = d * BigUint<>(y) + BigUint<>(x);
+    }
+    assert(ToString(a) == ToString(c));
+    assert(ToString(a * b) == ToString(c * d));
+    assert(ToString(a + b) == ToString(c + d));
+    assert(a * b == b * a);
+  }
+
+  // Karatsuba and Toom-3, also with low thresholds to recurse deeply, against schoolbook
+  using binary_internal::Limbs;
+  using binary_internal::Thresholds;
+  const Thresholds kSchoolbook{SIZE_MAX, SIZE_MAX};
+  const Thresholds kLow{4, 9};
+  for (size_t na : {1, 2, 5, 31, 32, 33, 100, 159, 160, 161, 500, 1000}) {
+    for (size_t nb : {na, na - na / 3, na / 2 + 1, na / 5 + 1}) {
+      // all ones maximizes the carries
+      for (bool ones : {false, true}) {
+        Limbs a(na), b(nb);
+        for (uint64_t& limb : a) limb = ones ? UINT64_MAX : random();
+        for (uint64_t& limb : b) limb = ones ? UINT64_MAX : random();
+        Limbs expected =
+            binary_internal::Multiply(a.data(), na, b.data(), nb, kSchoolbook);
+        assert(binary_internal::Multiply(a.data(), na, b.data(), nb) == expected);
+        assert(binary_internal::Multiply(b.data(), nb, a.data(), na) == expected);
+        if (na <= 200) {
+          assert(binary_internal::Multiply(a.data(), na, b.data(), nb, kLow) == expected);
+        }
+      }
+    }
+  }
+
+  std::cout << "OK" << std::endl;
+  return 0;
+}
@@ -0,0 +1,89 @@
+#ifndef DWCAS_H_
+#define DWCAS_H_
+
+#include <cstdint>
+
+#if defined(__x86_64__)
+#  include <cpuid.h>
+#endif
+
+#include "cpu_relax.h"
+
+// Double-width (128-bit) compare-and-swap, e.g. for a pointer next to a full 64-bit counter:
+//   DwcasPair head = DwcasLoad(&list);
+//   while (!Dwcas(&list, &head, {new_ptr, head.hi + 1})) {
+//   }
+//
+// On x86-64 this is lock cmpxchg16b. The instruction is missing on the earliest x86-64 CPUs, so
+// support is checked once with cpuid, and without it, as on other architectures, every DWCAS
+// operation takes one of a set of spin locks hashed by address instead. The choice is made once
+// per process, so the two paths never mix on the same pair. TSan cannot see through the inline
+// asm, so TSan builds always take the locks.
+
+struct alignas(16) DwcasPair {
+  uint64_t lo;
+  uint64_t hi;
+};
+
+inline bool HasDwcas() {
+#if defined(__x86_64__) && !defined(__SANITIZE_THREAD__)
+  static const bool has = [] {
+    unsigned eax, ebx, ecx, edx;
+    return __get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & bit_CMPXCHG16B);
+  }();
+  return has;
+#else
+  return false;
+#endif
+}
+
+namespace dwcas_internal {
+
+inline uint32_t* LockFor(const DwcasPair* addr) {
+  alignas(64) static uint32_t locks[64][16];
+  return &locks[(reinterpret_cast<uintptr_t>(addr) >> 4) % 64][0];
+}
+
+inline void Lock(uint32_t* lock) {
+  while (__atomic_exchange_n(lock, 1, __ATOMIC_ACQUIRE)) {
+    while (__atomic_load_n(lock, __ATOMIC_RELAXED)) CpuRelax();
+  }
+}
+
+inline void Unlock(uint32_t* lock) { __atomic_store_n(lock, 0, __ATOMIC_RELEASE); }
+
+}  // namespace dwcas_internal
+
+// If *addr equals *expected, stores desired and returns true. Otherwise loads *addr into
+// *expected and returns false. Full barrier.
+inline bool Dwcas(DwcasPair* addr, DwcasPair* expected, DwcasPair desired) {
+#if defined(__x86_64__)
+  if (HasDwcas()) {
+    bool ok;
+    asm volatile("lock cmpxchg16b %1"
+                 : "=@ccz"(ok), "+m"(*addr), "+a"(expected->lo), "+d"(expected->hi)
+                 : "b"(desired.lo), "c"(desired.hi)
+                 : "memory");
+    return ok;
+  }
+#endif
+
+  uint32_t* lock = dwcas_internal::LockFor(addr);
+  dwcas_internal::Lock(lock);
+  bool ok = addr->lo == expected->lo && addr->hi == expected->hi;
+  if (ok)
+    *addr = desired;
+  else
+    *expected = *addr;
+  dwcas_internal::Unlock(lock);
+  return ok;
+}
+
+// Atomic 128-bit load. cmpxchg16b always writes, so this needs writable memory.
+inline DwcasPair DwcasLoad(DwcasPair* addr) {
+  DwcasPair value = {0, 0};
+  Dwcas(addr, &value, value);
+  return value;
+}
+
+#endif  // DWCAS_H_
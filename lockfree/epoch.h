@@ -0,0 +1,234 @@
+#ifndef EPOCH_H_
+#define EPOCH_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "atomic.h"
+
+// Epoch-based reclamation (EBR): deferred freeing for lock-free structures.
+//
+// Each thread registers with an EpochDomain once, through an EpochThread, and wraps every access
+// to shared nodes in an EpochGuard. A node that has been unlinked is handed to Retire() instead
+// of being freed. It's tagged with the global epoch at that point and freed only once the global
+// epoch is two ahead of the tag. The global epoch advances only when every thread inside a guard
+// has observed the current one, so by then no guard that could still see the node is open.
+//
+//   EpochDomain domain;
+//   ...
+//   EpochThread thread(&domain);
+//   {
+//     EpochGuard guard(&thread);
+//     Node* node = head.Load(MemoryOrder::kAcquire);
+//     ... unlink node ...
+//     thread.Retire(node);
+//   }
+//
+// Retired nodes are kept in three per-thread bags, one per epoch modulo 3, and freed a bag at a
+// time. A thread stalled inside a guard stops the epoch, so garbage then grows without bound.
+
+class EpochThread;
+
+class EpochDomain {
+  friend class EpochThread;
+
+ public:
+  EpochDomain() = default;
+
+  EpochDomain(const EpochDomain& other) = delete;
+
+  // No thread may be registered any more. Frees everything that is still retired.
+  ~EpochDomain();
+
+  EpochDomain& operator=(const EpochDomain& other) = delete;
+
+ private:
+  struct Retired {
+    void* ptr;
+    void (*deleter)(void*);
+  };
+
+  struct Bag {
+    uint64_t epoch = 0;
+    std::vector<Retired> items;
+  };
+
+  // One per registered thread. Records are never freed before the domain, only reused.
+  struct Record {
+    // (epoch << 1) | active
+    Atomic<uint64_t> local{0};
+    Atomic<bool> in_use{true};
+    Record* next = nullptr;
+
+    // owner thread only
+    size_t depth = 0;
+    size_t nretired = 0;
+    Bag bags[3];
+  };
+
+  Record* Acquire();
+
+  bool TryAdvance();
+
+  static void Free(Bag* bag) {
+    for (const Retired& r : bag->items) r.deleter(r.ptr);
+    bag->items.clear();
+  }
+
+  Atomic<uint64_t> epoch_{0};
+  Atomic<Record*> records_{nullptr};
+};
+
+// A thread's registration with an EpochDomain. Create one per thread and keep it for as long as
+// the thread uses the domain.
+class EpochThread {
+  friend class EpochGuard;
+
+ public:
+  explicit EpochThread(EpochDomain* domain) : domain_(domain), record_(domain->Acquire()) {}
+
+  EpochThread(const EpochThread& other) = delete;
+
+  // What this thread retired and couldn't free yet stays with its record for the next thread.
+  ~EpochThread() { record_->in_use.Store(false, MemoryOrder::kRelease); }
+
+  EpochThread& operator=(const EpochThread& other) = delete;
+
+  // Frees ptr with deleter once no guard can still reference it.
+  void Retire(void* ptr, void (*deleter)(void*)) {
+    uint64_t epoch = domain_->epoch_.Load();
+    EpochDomain::Bag& bag = record_->bags[epoch % 3];
+    // a bag for an older epoch with the same index is at least three epochs old: safe
+    if (bag.epoch != epoch) {
+      EpochDomain::Free(&bag);
+      bag.epoch = epoch;
+    }
+    bag.items.push_back({ptr, deleter});
+
+    if (++record_->nretired % kAdvanceThreshold == 0) {
+      domain_->TryAdvance();
+      Collect();
+    }
+  }
+
+  template <typename T>
+  void Retire(T* ptr) {
+    Retire(ptr, [](void* p) { delete static_cast<T*>(p); });
+  }
+
+  // retired nodes not freed yet
+  size_t Pending() const {
+    size_t n = 0;
+    for (const EpochDomain::Bag& bag : record_->bags) n += bag.items.size();
+    return n;
+  }
+
+  // Frees the bags that are at least two epochs old.
+  void Collect() {
+    uint64_t epoch = domain_->epoch_.Load(MemoryOrder::kAcquire);
+    for (EpochDomain::Bag& bag : record_->bags) {
+      if (!bag.items.empty() && bag.epoch + 2 <= epoch) EpochDomain::Free(&bag);
+    }
+  }
+
+ private:
+  // retirements between attempts to advance the global epoch
+  static constexpr size_t kAdvanceThreshold = 64;
+
+  void Enter() {
+    if (record_->depth++ > 0) return;
+
+    uint64_t epoch = domain_->epoch_.Load(MemoryOrder::kRelaxed);
+    record_->local.Store((epoch << 1) | 1, MemoryOrder::kRelaxed);
+    // publish that we are active before reading any shared pointer
+    AtomicFence(MemoryOrder::kSeqCst);
+  }
+
+  void Leave() {
+    if (--record_->depth > 0) return;
+
+    uint64_t local = record_->local.Load(MemoryOrder::kRelaxed);
+    record_->local.Store(local & ~static_cast<uint64_t>(1), MemoryOrder::kRelease);
+  }
+
+  EpochDomain* domain_;
+  EpochDomain::Record* record_;
+};
+
+// Critical section: shared nodes loaded inside it stay allocated until it ends. Guards nest.
+class EpochGuard {
+ public:
+  explicit EpochGuard(EpochThread* thread) : thread_(thread) { thread_->Enter(); }
+
+  EpochGuard(const EpochGuard& other) = delete;
+
+  ~EpochGuard() { thread_->Leave(); }
+
+  EpochGuard& operator=(const EpochGuard& other) = delete;
+
+  // Same shape as HazardGuard::Protect(). Inside a guard every loaded node is protected already,
+  // so this is just an acquire load.
+  template <typename T>
+  T* Protect(size_t /*slot*/, const Atomic<T*>& src) {
+    return src.Load(MemoryOrder::kAcquire);
+  }
+
+ private:
+  EpochThread* thread_;
+};
+
+// Names the EBR classes for structures that take the reclamation scheme as a template argument:
+//   typename Reclaimer::Domain domain;
+//   typename Reclaimer::Thread thread(&domain);
+//   typename Reclaimer::Guard guard(&thread);
+//   Node* node = guard.Protect(0, head);
+//   thread.Retire(node);
+struct EpochReclaimer {
+  using Domain = EpochDomain;
+  using Thread = EpochThread;
+  using Guard = EpochGuard;
+};
+
+inline EpochDomain::~EpochDomain() {
+  Record* record = records_.Load(MemoryOrder::kAcquire);
+  while (record) {
+    Record* next = record->next;
+    for (Bag& bag : record->bags) Free(&bag);
+    delete record;
+    record = next;
+  }
+}
+
+inline EpochDomain::Record* EpochDomain::Acquire() {
+  // reuse the record of a thread that has gone away
+  for (Record* record = records_.Load(MemoryOrder::kAcquire); record; record = record->next) {
+    bool in_use = false;
+    if (!record->in_use.Load(MemoryOrder::kRelaxed) &&
+        record->in_use.CompareExchange(in_use, true, MemoryOrder::kAcquire)) {
+      return record;
+    }
+  }
+
+  auto record = new Record;
+  Record* head = records_.Load(MemoryOrder::kRelaxed);
+  do {
+    record->next = head;
+  } while (!records_.CompareExchangeWeak(head, record, MemoryOrder::kRelease));
+  return record;
+}
+
+inline bool EpochDomain::TryAdvance() {
+  uint64_t epoch = epoch_.Load();
+  // pairs with the fence in EpochThread::Enter()
+  AtomicFence(MemoryOrder::kSeqCst);
+
+  for (Record* record = records_.Load(MemoryOrder::kAcquire); record; record = record->next) {
+    uint64_t local = record->local.Load(MemoryOrder::kAcquire);
+    if ((local & 1) && (local >> 1) != epoch) return false;
+  }
+
+  return epoch_.CompareExchange(epoch, epoch + 1, MemoryOrder::kAcqRel);
+}
+
+#endif  // EPOCH_H_
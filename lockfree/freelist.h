@@ -0,0 +1,98 @@
+#ifndef FREELIST_H_
+#define FREELIST_H_
+
+#include <cstdint>
+
+#include "atomic.h"
+#include "dwcas.h"
+#include "tagged_ptr.h"
+
+// Lock-free LIFO freelists of caller-owned nodes, linked through a void* field of the node, the
+// same convention as MsgQueue's link:
+//   FreeList<ThrdpoolTaskEntry, &ThrdpoolTaskEntry::link> entries;
+//   entries.Push(entry);
+//   ThrdpoolTaskEntry* entry = entries.Pop();
+//
+// A plain pointer CAS in Pop() suffers from ABA: between reading head->link and the CAS, head can
+// be popped, reused and pushed back, and the CAS would install a stale link. Both lists tag the
+// head with a counter that every update bumps. FreeList packs a 16-bit tag with the pointer into
+// one word, while DwcasFreeList keeps a full 64-bit counter next to it and pays for a 128-bit CAS.
+//
+// Pop() may read the link of a node that another thread has just popped, so nodes must stay
+// mapped while any thread can still use the list: recycle them through the list and free them
+// only when it is no longer in use.
+
+namespace freelist_internal {
+
+template <typename T, void* T::*Link>
+inline T* LoadLink(T* node) {
+  return static_cast<T*>(__atomic_load_n(&(node->*Link), __ATOMIC_RELAXED));
+}
+
+template <typename T, void* T::*Link>
+inline void StoreLink(T* node, T* next) {
+  __atomic_store_n(&(node->*Link), static_cast<void*>(next), __ATOMIC_RELAXED);
+}
+
+}  // namespace freelist_internal
+
+template <typename T, void* T::*Link>
+class FreeList {
+ public:
+  FreeList() = default;
+
+  FreeList(const FreeList& other) = delete;
+
+  FreeList& operator=(const FreeList& other) = delete;
+
+  void Push(T* node) {
+    TaggedPtr<T> head = head_.Load(MemoryOrder::kRelaxed);
+    do {
+      freelist_internal::StoreLink<T, Link>(node, head.Ptr());
+    } while (!head_.CompareExchangeWeak(head, head.Next(node), MemoryOrder::kRelease));
+  }
+
+  T* Pop() {
+    TaggedPtr<T> head = head_.Load(MemoryOrder::kAcquire);
+    while (head.Ptr()) {
+      T* next = freelist_internal::LoadLink<T, Link>(head.Ptr());
+      if (head_.CompareExchangeWeak(head, head.Next(next), MemoryOrder::kAcquire)) break;
+    }
+    return head.Ptr();
+  }
+
+ private:
+  Atomic<TaggedPtr<T>> head_;
+};
+
+template <typename T, void* T::*Link>
+class DwcasFreeList {
+ public:
+  DwcasFreeList() = default;
+
+  DwcasFreeList(const DwcasFreeList& other) = delete;
+
+  DwcasFreeList& operator=(const DwcasFreeList& other) = delete;
+
+  void Push(T* node) {
+    DwcasPair head = DwcasLoad(&head_);
+    do {
+      freelist_internal::StoreLink<T, Link>(node, reinterpret_cast<T*>(head.lo));
+    } while (!Dwcas(&head_, &head, {reinterpret_cast<uint64_t>(node), head.hi + 1}));
+  }
+
+  T* Pop() {
+    DwcasPair head = DwcasLoad(&head_);
+    while (head.lo) {
+      T* next = freelist_internal::LoadLink<T, Link>(reinterpret_cast<T*>(head.lo));
+      if (Dwcas(&head_, &head, {reinterpret_cast<uint64_t>(next), head.hi + 1})) break;
+    }
+    return reinterpret_cast<T*>(head.lo);
+  }
+
+ private:
+  // lo: head node, hi: update counter
+  DwcasPair head_ = {0, 0};
+};
+
+#endif  // FREELIST_H_
@@ -0,0 +1,79 @@
+#include "freelist.h"
+
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "dwcas.h"
+#include "tagged_ptr.h"
+
+struct Entry {
+  void* link;
+  Atomic<int> owners{0};
+};
+
+void TestTaggedPtr() {
+  int x;
+  TaggedPtr<int> p(&x, 0xffff);
+  assert(p.Ptr() == &x);
+  assert(p.Tag() == 0xffff);
+
+  TaggedPtr<int> q = p.Next(nullptr);
+  assert(q.Ptr() == nullptr);
+  assert(q.Tag() == 0);
+  assert(p != q);
+  assert(p == TaggedPtr<int>(&x, 0xffff));
+}
+
+void TestDwcas() {
+  DwcasPair pair = {1, 2};
+  DwcasPair expected = {1, 3};
+  assert(!Dwcas(&pair, &expected, {4, 5}));
+  assert(expected.lo == 1 && expected.hi == 2);
+  assert(Dwcas(&pair, &expected, {4, 5}));
+  DwcasPair value = DwcasLoad(&pair);
+  assert(value.lo == 4 && value.hi == 5);
+}
+
+// Threads keep popping entries and pushing them back. ABA in Pop() would hand the same entry to
+// two threads at once.
+template <typename List>
+void TestStress() {
+  const int kThreads = 8;
+  const int kEntries = 16;
+  const int kOps = 100000;
+
+  std::vector<Entry> entries(kEntries);
+  List list;
+  for (Entry& entry : entries) list.Push(&entry);
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kThreads; ++i) {
+    threads.emplace_back([&list, kOps] {
+      for (int j = 0; j < kOps; ++j) {
+        Entry* entry = list.Pop();
+        if (!entry) continue;
+        int owners = entry->owners.FetchAdd(1);
+        assert(owners == 0);
+        entry->owners.FetchSub(1);
+        list.Push(entry);
+      }
+    });
+  }
+  for (auto& t : threads) t.join();
+
+  int n = 0;
+  while (list.Pop()) ++n;
+  assert(n == kEntries);
+}
+
+int main() {
+  TestTaggedPtr();
+  TestDwcas();
+  TestStress<FreeList<Entry, &Entry::link>>();
+  TestStress<DwcasFreeList<Entry, &Entry::link>>();
+  std::cout << "OK" << std::endl;
+  return 0;
+}
@@ -0,0 +1,218 @@
+#ifndef HAZARD_POINTER_H_
+#define HAZARD_POINTER_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "atomic.h"
+
+// Hazard pointers: deferred freeing whose garbage stays bounded even if a reader stalls.
+//
+// A thread publishes each shared node it is about to dereference in one of its hazard slots, and
+// rechecks that the node is still reachable. Retired nodes collect in a per-thread list. Once the
+// list reaches the scan threshold, the thread snapshots every published hazard and frees the
+// retired nodes that aren't among them. The threshold grows with the number of hazard slots, so
+// each scan frees at least half the list and its cost is amortized over the retirements. A
+// stalled reader pins only the nodes in its own slots.
+//
+//   HazardDomain domain;
+//   ...
+//   HazardThread thread(&domain);
+//   {
+//     HazardGuard guard(&thread);
+//     Node* node = guard.Protect(0, head);
+//     ... unlink node ...
+//     thread.Retire(node);
+//   }
+
+class HazardThread;
+
+class HazardDomain {
+  friend class HazardThread;
+
+ public:
+  // hazard slots per thread
+  static constexpr size_t kSlots = 2;
+
+  HazardDomain() = default;
+
+  HazardDomain(const HazardDomain& other) = delete;
+
+  // No thread may be registered any more. Frees everything that is still retired.
+  ~HazardDomain();
+
+  HazardDomain& operator=(const HazardDomain& other) = delete;
+
+ private:
+  struct Retired {
+    void* ptr;
+    void (*deleter)(void*);
+  };
+
+  // One per registered thread. Records are never freed before the domain, only reused.
+  struct Record {
+    Atomic<void*> hazards[kSlots];
+    Atomic<bool> in_use{true};
+    Record* next = nullptr;
+
+    // owner thread only
+    std::vector<Retired> retired;
+  };
+
+  Record* Acquire();
+
+  Atomic<Record*> records_{nullptr};
+  Atomic<size_t> nrecords_{0};
+};
+
+// A thread's registration with a HazardDomain. Create one per thread and keep it for as long as
+// the thread uses the domain.
+class HazardThread {
+ public:
+  explicit HazardThread(HazardDomain* domain) : domain_(domain), record_(domain->Acquire()) {}
+
+  HazardThread(const HazardThread& other) = delete;
+
+  // What this thread retired and couldn't free yet stays with its record for the next thread.
+  ~HazardThread() {
+    for (auto& hazard : record_->hazards) hazard.Store(nullptr, MemoryOrder::kRelease);
+    Scan();
+    record_->in_use.Store(false, MemoryOrder::kRelease);
+  }
+
+  HazardThread& operator=(const HazardThread& other) = delete;
+
+  // Loads src and publishes it in hazard slot, retrying until src is still the same after
+  // publishing. The result stays allocated until the slot is cleared or reused.
+  template <typename T>
+  T* Protect(size_t slot, const Atomic<T*>& src) {
+    T* ptr = src.Load(MemoryOrder::kRelaxed);
+    while (true) {
+      record_->hazards[slot].Store(ptr, MemoryOrder::kRelaxed);
+      // publish the hazard before re-reading src, pairs with the fence in Scan()
+      AtomicFence(MemoryOrder::kSeqCst);
+      T* again = src.Load(MemoryOrder::kAcquire);
+      if (again == ptr) return ptr;
+      ptr = again;
+    }
+  }
+
+  void Clear(size_t slot) { record_->hazards[slot].Store(nullptr, MemoryOrder::kRelease); }
+
+  // Frees ptr with deleter once no hazard slot holds it.
+  void Retire(void* ptr, void (*deleter)(void*)) {
+    record_->retired.push_back({ptr, deleter});
+    if (record_->retired.size() >= Threshold()) Scan();
+  }
+
+  template <typename T>
+  void Retire(T* ptr) {
+    Retire(ptr, [](void* p) { delete static_cast<T*>(p); });
+  }
+
+  // Frees every retired node that no thread has published.
+  void Scan() {
+    AtomicFence(MemoryOrder::kSeqCst);
+
+    std::vector<void*>& hazards = scratch_;
+    hazards.clear();
+    for (auto record = domain_->records_.Load(MemoryOrder::kAcquire); record;
+         record = record->next) {
+      for (auto& hazard : record->hazards) {
+        void* ptr = hazard.Load(MemoryOrder::kAcquire);
+        if (ptr) hazards.push_back(ptr);
+      }
+    }
+    std::sort(hazards.begin(), hazards.end());
+
+    std::vector<HazardDomain::Retired>& retired = record_->retired;
+    size_t kept = 0;
+    for (size_t i = 0; i < retired.size(); ++i) {
+      if (std::binary_search(hazards.begin(), hazards.end(), retired[i].ptr)) {
+        retired[kept++] = retired[i];
+      } else {
+        retired[i].deleter(retired[i].ptr);
+      }
+    }
+    retired.resize(kept);
+  }
+
+  // retired nodes not freed yet
+  size_t Pending() const { return record_->retired.size(); }
+
+ private:
+  // twice the number of hazards, so that a scan always frees at least half of the list
+  size_t Threshold() const {
+    size_t threshold = 2 * HazardDomain::kSlots * domain_->nrecords_.Load(MemoryOrder::kRelaxed);
+    return threshold > kMinThreshold ? threshold : kMinThreshold;
+  }
+
+  static constexpr size_t kMinThreshold = 64;
+
+  HazardDomain* domain_;
+  HazardDomain::Record* record_;
+  std::vector<void*> scratch_;
+};
+
+// Clears the thread's hazard slots when it goes out of scope.
+class HazardGuard {
+ public:
+  explicit HazardGuard(HazardThread* thread) : thread_(thread) {}
+
+  HazardGuard(const HazardGuard& other) = delete;
+
+  ~HazardGuard() {
+    for (size_t i = 0; i < HazardDomain::kSlots; ++i) thread_->Clear(i);
+  }
+
+  HazardGuard& operator=(const HazardGuard& other) = delete;
+
+  template <typename T>
+  T* Protect(size_t slot, const Atomic<T*>& src) {
+    return thread_->Protect(slot, src);
+  }
+
+ private:
+  HazardThread* thread_;
+};
+
+// Names the hazard pointer classes for structures that take the reclamation scheme as a template
+// argument; see EpochReclaimer.
+struct HazardReclaimer {
+  using Domain = HazardDomain;
+  using Thread = HazardThread;
+  using Guard = HazardGuard;
+};
+
+inline HazardDomain::~HazardDomain() {
+  Record* record = records_.Load(MemoryOrder::kAcquire);
+  while (record) {
+    Record* next = record->next;
+    for (const Retired& r : record->retired) r.deleter(r.ptr);
+    delete record;
+    record = next;
+  }
+}
+
+inline HazardDomain::Record* HazardDomain::Acquire() {
+  // reuse the record of a thread that has gone away
+  for (Record* record = records_.Load(MemoryOrder::kAcquire); record; record = record->next) {
+    bool in_use = false;
+    if (!record->in_use.Load(MemoryOrder::kRelaxed) &&
+        record->in_use.CompareExchange(in_use, true, MemoryOrder::kAcquire)) {
+      return record;
+    }
+  }
+
+  auto record = new Record;
+  Record* head = records_.Load(MemoryOrder::kRelaxed);
+  do {
+    record->next = head;
+  } while (!records_.CompareExchangeWeak(head, record, MemoryOrder::kRelease));
+  nrecords_.FetchAdd(1, MemoryOrder::kRelaxed);
+  return record;
+}
+
+#endif  // HAZARD_POINTER_H_
@@ -0,0 +1,96 @@
+#ifndef MS_QUEUE_H_
+#define MS_QUEUE_H_
+
+#include "atomic.h"
+
+// Lock-free MPMC FIFO queue (Michael-Scott), parameterized on the reclamation scheme:
+//   MsQueue<int, EpochReclaimer> or MsQueue<int, HazardReclaimer>
+// Dequeued dummy nodes are retired through Reclaimer::Thread, and every shared node is
+// dereferenced only after Reclaimer::Guard::Protect() has made it safe to. Protect() slot 0
+// holds head or tail, slot 1 holds head->next.
+template <typename T, typename Reclaimer>
+class MsQueue {
+ public:
+  using Thread = typename Reclaimer::Thread;
+
+  MsQueue() {
+    auto dummy = new Node;
+    head_.Store(dummy, MemoryOrder::kRelaxed);
+    tail_.Store(dummy, MemoryOrder::kRelaxed);
+  }
+
+  MsQueue(const MsQueue& other) = delete;
+
+  // No thread may use the queue any more.
+  ~MsQueue() {
+    Node* node = head_.Load(MemoryOrder::kAcquire);
+    while (node) {
+      Node* next = node->next.Load(MemoryOrder::kRelaxed);
+      delete node;
+      node = next;
+    }
+  }
+
+  MsQueue& operator=(const MsQueue& other) = delete;
+
+  void Enqueue(Thread* thread, const T& value) {
+    auto node = new Node;
+    node->value = value;
+
+    typename Reclaimer::Guard guard(thread);
+    while (true) {
+      Node* tail = guard.Protect(0, tail_);
+      Node* next = tail->next.Load(MemoryOrder::kAcquire);
+      if (tail != tail_.Load(MemoryOrder::kAcquire)) continue;
+
+      if (next) {
+        // tail is lagging behind, help move it
+        tail_.CompareExchange(tail, next, MemoryOrder::kRelease);
+        continue;
+      }
+
+      Node* null = nullptr;
+      if (tail->next.CompareExchange(null, node, MemoryOrder::kRelease)) {
+        tail_.CompareExchange(tail, node, MemoryOrder::kRelease);
+        return;
+      }
+    }
+  }
+
+  bool Dequeue(Thread* thread, T* value) {
+    typename Reclaimer::Guard guard(thread);
+    while (true) {
+      Node* head = guard.Protect(0, head_);
+      Node* tail = tail_.Load(MemoryOrder::kAcquire);
+      Node* next = guard.Protect(1, head->next);
+      if (head != head_.Load(MemoryOrder::kAcquire)) continue;
+
+      if (!next) return false;
+
+      if (head == tail) {
+        // tail is lagging behind, help move it
+        tail_.CompareExchange(tail, next, MemoryOrder::kRelease);
+        continue;
+      }
+
+      // read before the CAS: once head moves, another dequeue may retire next
+      T result = next->value;
+      if (head_.CompareExchange(head, next, MemoryOrder::kAcqRel)) {
+        *value = result;
+        thread->Retire(head);
+        return true;
+      }
+    }
+  }
+
+ private:
+  struct Node {
+    T value;
+    Atomic<Node*> next{nullptr};
+  };
+
+  alignas(64) Atomic<Node*> head_;
+  alignas(64) Atomic<Node*> tail_;
+};
+
+#endif  // MS_QUEUE_H_
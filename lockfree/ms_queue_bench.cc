@@ -0,0 +1,74 @@
+// EBR against hazard pointers on MsQueue: enqueue/dequeue pairs per second, and the garbage left
+// unreclaimed, first with every thread running and then with one thread parked inside a guard.
+//   g++ -std=c++17 -O2 -pthread -I../atomic ms_queue_bench.cc -o ms_queue_bench
+//   ./ms_queue_bench [pairs per thread]
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "epoch.h"
+#include "hazard_pointer.h"
+#include "ms_queue.h"
+
+template <typename Reclaimer>
+void Run(const char* name, size_t nthreads, size_t npairs, bool stall) {
+  typename Reclaimer::Domain domain;
+  MsQueue<uint64_t, Reclaimer> queue;
+  Atomic<bool> done(false);
+
+  // sits in a guard for the whole run, like a reader that got descheduled
+  std::thread staller;
+  if (stall) {
+    staller = std::thread([&domain, &done] {
+      typename Reclaimer::Thread thread(&domain);
+      typename Reclaimer::Guard guard(&thread);
+      while (!done.Load()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    });
+  }
+
+  std::vector<size_t> max_pending(nthreads, 0);
+  auto start = std::chrono::steady_clock::now();
+
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < nthreads; ++i) {
+    threads.emplace_back([&queue, &domain, &max_pending, i, npairs] {
+      typename Reclaimer::Thread thread(&domain);
+      uint64_t value;
+      for (size_t j = 0; j < npairs; ++j) {
+        queue.Enqueue(&thread, j);
+        queue.Dequeue(&thread, &value);
+        if (j % 1024 == 0 && thread.Pending() > max_pending[i]) max_pending[i] = thread.Pending();
+      }
+    });
+  }
+  for (auto& t : threads) t.join();
+
+  double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start)
+                  .count();
+  done.Store(true);
+  if (stall) staller.join();
+
+  size_t pending = 0;
+  for (size_t p : max_pending) pending += p;
+  printf("%-8s %-6s %8zu %12.2f %14zu\n", name, stall ? "yes" : "no", nthreads,
+         nthreads * npairs / ns * 1e3, pending);
+}
+
+int main(int argc, char* argv[]) {
+  size_t npairs = argc > 1 ? strtoul(argv[1], nullptr, 10) : 1000000;
+  size_t ncpus = std::thread::hardware_concurrency();
+
+  printf("%-8s %-6s %8s %12s %14s\n", "scheme", "stall", "threads", "Mpairs/s", "max garbage");
+  for (bool stall : {false, true}) {
+    for (size_t nthreads = 1; nthreads <= ncpus; nthreads *= 2) {
+      Run<EpochReclaimer>("epoch", nthreads, npairs, stall);
+      Run<HazardReclaimer>("hazard", nthreads, npairs, stall);
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,82 @@
+#include "ms_queue.h"
+
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "epoch.h"
+#include "hazard_pointer.h"
+
+template <typename Reclaimer>
+void TestSingleThread() {
+  typename Reclaimer::Domain domain;
+  typename Reclaimer::Thread thread(&domain);
+  MsQueue<int, Reclaimer> queue;
+
+  int value;
+  assert(!queue.Dequeue(&thread, &value));
+
+  queue.Enqueue(&thread, 1);
+  queue.Enqueue(&thread, 2);
+  assert(queue.Dequeue(&thread, &value) && value == 1);
+  assert(queue.Dequeue(&thread, &value) && value == 2);
+  assert(!queue.Dequeue(&thread, &value));
+
+  // left in the queue, freed by its destructor
+  queue.Enqueue(&thread, 3);
+}
+
+template <typename Reclaimer>
+void TestStress() {
+  const uint64_t kProducers = 4;
+  const uint64_t kConsumers = 4;
+  const uint64_t kMsgs = 100000;
+
+  typename Reclaimer::Domain domain;
+  MsQueue<uint64_t, Reclaimer> queue;
+  Atomic<uint64_t> received(0);
+
+  std::vector<std::thread> threads;
+  for (uint64_t p = 0; p < kProducers; ++p) {
+    threads.emplace_back([&queue, &domain, p, kMsgs] {
+      typename Reclaimer::Thread thread(&domain);
+      for (uint64_t i = 0; i < kMsgs; ++i) queue.Enqueue(&thread, p << 32 | i);
+    });
+  }
+
+  std::vector<uint64_t> sum(kConsumers, 0);
+  for (uint64_t c = 0; c < kConsumers; ++c) {
+    threads.emplace_back([&queue, &domain, &received, &sum, c, kProducers, kMsgs] {
+      typename Reclaimer::Thread thread(&domain);
+      // per producer, values come out in the order they went in
+      std::vector<int64_t> last(kProducers, -1);
+      uint64_t value;
+      while (received.Load() < kProducers * kMsgs) {
+        if (!queue.Dequeue(&thread, &value)) continue;
+
+        received.FetchAdd(1);
+        uint64_t producer = value >> 32;
+        int64_t seq = static_cast<int64_t>(value & 0xffffffff);
+        assert(seq > last[producer]);
+        last[producer] = seq;
+        sum[c] += seq;
+      }
+    });
+  }
+  for (auto& t : threads) t.join();
+
+  uint64_t total = 0;
+  for (uint64_t s : sum) total += s;
+  assert(total == kProducers * (kMsgs * (kMsgs - 1) / 2));
+}
+
+int main() {
+  TestSingleThread<EpochReclaimer>();
+  TestSingleThread<HazardReclaimer>();
+  TestStress<EpochReclaimer>();
+  TestStress<HazardReclaimer>();
+  std::cout << "OK" << std::endl;
+  return 0;
+}
@@ -0,0 +1,40 @@
+#ifndef TAGGED_PTR_H_
+#define TAGGED_PTR_H_
+
+#include <cstdint>
+
+// Pointer and 16-bit tag packed into one 64-bit word, for ABA-safe single-width CAS:
+//   Atomic<TaggedPtr<Node>> head;
+//   TaggedPtr<Node> old = head.Load(MemoryOrder::kAcquire);
+//   head.CompareExchange(old, old.Next(node));
+// Bumping the tag on every update makes a CAS fail if the pointer was popped and pushed back in
+// between, unless exactly a multiple of 65536 updates happened meanwhile.
+//
+// Relies on user-space addresses fitting in 48 bits, as on x86-64 and aarch64 with 4-level page
+// tables. With 5-level paging or pointer tagging in hardware, use the DWCAS variants instead.
+template <typename T>
+class TaggedPtr {
+ public:
+  TaggedPtr() = default;
+
+  TaggedPtr(T* ptr, uint16_t tag)
+      : bits_((reinterpret_cast<uint64_t>(ptr) & kPtrMask) | static_cast<uint64_t>(tag) << 48) {}
+
+  T* Ptr() const { return reinterpret_cast<T*>(bits_ & kPtrMask); }
+
+  uint16_t Tag() const { return static_cast<uint16_t>(bits_ >> 48); }
+
+  // ptr with the next tag, the value to CAS in
+  TaggedPtr Next(T* ptr) const { return TaggedPtr(ptr, static_cast<uint16_t>(Tag() + 1)); }
+
+  bool operator==(const TaggedPtr& other) const { return bits_ == other.bits_; }
+
+  bool operator!=(const TaggedPtr& other) const { return bits_ != other.bits_; }
+
+ private:
+  static constexpr uint64_t kPtrMask = (static_cast<uint64_t>(1) << 48) - 1;
+
+  uint64_t bits_ = 0;
+};
+
+#endif  // TAGGED_PTR_H_
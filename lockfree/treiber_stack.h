@@ -0,0 +1,61 @@
+#ifndef TREIBER_STACK_H_
+#define TREIBER_STACK_H_
+
+#include "atomic.h"
+#include "epoch.h"
+
+// Lock-free LIFO stack (Treiber). Popped nodes are retired to an EpochDomain, because another
+// thread may still be reading node->next in a Pop() that is about to fail its CAS.
+template <typename T>
+class TreiberStack {
+ public:
+  explicit TreiberStack(EpochDomain* domain) : domain_(domain) {}
+
+  TreiberStack(const TreiberStack& other) = delete;
+
+  // No thread may use the stack any more.
+  ~TreiberStack() {
+    Node* node = head_.Load(MemoryOrder::kAcquire);
+    while (node) {
+      Node* next = node->next;
+      delete node;
+      node = next;
+    }
+  }
+
+  TreiberStack& operator=(const TreiberStack& other) = delete;
+
+  // Push never dereferences a shared node, so it needs no guard.
+  void Push(const T& value) {
+    auto node = new Node{value, head_.Load(MemoryOrder::kRelaxed)};
+    while (!head_.CompareExchangeWeak(node->next, node, MemoryOrder::kRelease)) {
+    }
+  }
+
+  // thread must be registered with the stack's domain
+  bool Pop(EpochThread* thread, T* value) {
+    EpochGuard guard(thread);
+
+    Node* node = head_.Load(MemoryOrder::kAcquire);
+    while (node && !head_.CompareExchangeWeak(node, node->next, MemoryOrder::kAcquire)) {
+    }
+    if (!node) return false;
+
+    *value = node->value;
+    thread->Retire(node);
+    return true;
+  }
+
+  EpochDomain* Domain() const { return domain_; }
+
+ private:
+  struct Node {
+    T value;
+    Node* next;
+  };
+
+  EpochDomain* domain_;
+  Atomic<Node*> head_{nullptr};
+};
+
+#endif  // TREIBER_STACK_H_
@@ -0,0 +1,78 @@
+// Push/pop pairs per second on the EBR-backed TreiberStack against a mutex-protected std::stack.
+//   g++ -std=c++17 -O2 -pthread -I../atomic treiber_stack_bench.cc -o treiber_stack_bench
+//   ./treiber_stack_bench [pairs per thread]
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <stack>
+#include <thread>
+#include <vector>
+
+#include "epoch.h"
+#include "treiber_stack.h"
+
+class LockedStack {
+ public:
+  void Push(uint64_t value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stack_.push(value);
+  }
+
+  bool Pop(uint64_t* value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stack_.empty()) return false;
+    *value = stack_.top();
+    stack_.pop();
+    return true;
+  }
+
+ private:
+  std::mutex mutex_;
+  std::stack<uint64_t> stack_;
+};
+
+template <typename Body>
+void Run(const char* name, size_t nthreads, size_t npairs, Body body) {
+  auto start = std::chrono::steady_clock::now();
+
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < nthreads; ++i) threads.emplace_back(body);
+  for (auto& t : threads) t.join();
+
+  double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start)
+                  .count();
+  printf("%-8s %8zu %12.2f\n", name, nthreads, nthreads * npairs / ns * 1e3);
+}
+
+int main(int argc, char* argv[]) {
+  size_t npairs = argc > 1 ? strtoul(argv[1], nullptr, 10) : 1000000;
+  size_t ncpus = std::thread::hardware_concurrency();
+
+  printf("%-8s %8s %12s\n", "stack", "threads", "Mpairs/s");
+  for (size_t nthreads = 1; nthreads <= ncpus; nthreads *= 2) {
+    EpochDomain domain;
+    TreiberStack<uint64_t> treiber(&domain);
+    Run("treiber", nthreads, npairs, [&treiber, &domain, npairs] {
+      EpochThread thread(&domain);
+      uint64_t value;
+      for (size_t i = 0; i < npairs; ++i) {
+        treiber.Push(i);
+        treiber.Pop(&thread, &value);
+      }
+    });
+
+    LockedStack locked;
+    Run("mutex", nthreads, npairs, [&locked, npairs] {
+      uint64_t value;
+      for (size_t i = 0; i < npairs; ++i) {
+        locked.Push(i);
+        locked.Pop(&value);
+      }
+    });
+  }
+
+  return 0;
+}
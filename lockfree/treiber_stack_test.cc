@@ -0,0 +1,70 @@
+#include "treiber_stack.h"
+
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "epoch.h"
+
+void TestSingleThread() {
+  EpochDomain domain;
+  EpochThread thread(&domain);
+  TreiberStack<int> stack(&domain);
+
+  int value;
+  assert(!stack.Pop(&thread, &value));
+
+  stack.Push(1);
+  stack.Push(2);
+  assert(stack.Pop(&thread, &value) && value == 2);
+  assert(stack.Pop(&thread, &value) && value == 1);
+  assert(!stack.Pop(&thread, &value));
+
+  // left on the stack, freed by its destructor
+  stack.Push(3);
+}
+
+void TestStress() {
+  const int kThreads = 8;
+  const int kOps = 200000;
+
+  EpochDomain domain;
+  TreiberStack<uint64_t> stack(&domain);
+  std::vector<uint64_t> pushed(kThreads, 0), popped(kThreads, 0);
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kThreads; ++i) {
+    threads.emplace_back([&stack, &domain, &pushed, &popped, i, kOps] {
+      EpochThread thread(&domain);
+      uint64_t value;
+      for (int j = 0; j < kOps; ++j) {
+        uint64_t v = static_cast<uint64_t>(i) * kOps + j;
+        stack.Push(v);
+        pushed[i] += v;
+        // pop a bit less than we push, so the stack never stays empty
+        if (j % 4 != 0 && stack.Pop(&thread, &value)) popped[i] += value;
+      }
+    });
+  }
+  for (auto& t : threads) t.join();
+
+  uint64_t total_pushed = 0, total_popped = 0;
+  for (int i = 0; i < kThreads; ++i) {
+    total_pushed += pushed[i];
+    total_popped += popped[i];
+  }
+
+  EpochThread thread(&domain);
+  uint64_t value;
+  while (stack.Pop(&thread, &value)) total_popped += value;
+  assert(total_popped == total_pushed);
+}
+
+int main() {
+  TestSingleThread();
+  TestStress();
+  std::cout << "OK" << std::endl;
+  return 0;
+}
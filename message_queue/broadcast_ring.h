@@ -0,0 +1,112 @@
+#ifndef BROADCAST_RING_H_
+#define BROADCAST_RING_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+// Disruptor-style ring that fans every message out to a fixed set of consumers. The single
+// producer writes each slot once, and every consumer reads it in place through its own cursor.
+// The producer is gated on the slowest consumer, so it never overwrites a slot that someone
+// hasn't read yet.
+//
+// producer:
+//   T& slot = ring.Claim();
+//   Fill(slot);
+//   ring.Publish();
+//   ...
+//   ring.Close();
+//
+// consumer id:
+//   while (size_t n = ring.Wait(id)) {
+//     uint64_t seq = ring.Next(id);
+//     for (size_t i = 0; i < n; ++i) Process(ring.At(seq + i));
+//     ring.Release(id, n);
+//   }
+template <typename T>
+class BroadcastRing {
+ public:
+  // capacity is rounded up to a power of two
+  BroadcastRing(size_t capacity, size_t nconsumers)
+      : nconsumers_(nconsumers), consumers_(new Cursor[nconsumers]) {
+    size_t size = 1;
+    while (size < capacity) size <<= 1;
+    mask_ = size - 1;
+    slots_.reset(new T[size]);
+  }
+
+  BroadcastRing(const BroadcastRing& other) = delete;
+
+  ~BroadcastRing() {}
+
+  BroadcastRing& operator=(const BroadcastRing& other) = delete;
+
+  // Producer only. Waits until the next slot has been released by every consumer.
+  T& Claim() {
+    while (claimed_ - gate_ > mask_) {
+      gate_ = MinConsumer();
+      if (claimed_ - gate_ > mask_) std::this_thread::yield();
+    }
+    return slots_[claimed_ & mask_];
+  }
+
+  // Producer only. Makes the slot returned by the last Claim() visible to consumers.
+  void Publish() { cursor_.seq.store(++claimed_, std::memory_order_release); }
+
+  // Producer only. Consumers return 0 from Wait() once they have read everything.
+  void Close() { closed_.store(true, std::memory_order_release); }
+
+  // Number of published slots consumer id hasn't read, starting at Next(id). Waits until there
+  // is at least one, or returns 0 if the ring has been closed and fully read.
+  size_t Wait(size_t id) const {
+    uint64_t next = consumers_[id].seq.load(std::memory_order_relaxed);
+    while (true) {
+      bool closed = closed_.load(std::memory_order_acquire);
+      uint64_t avail = cursor_.seq.load(std::memory_order_acquire) - next;
+      if (avail > 0 || closed) return avail;
+      std::this_thread::yield();
+    }
+  }
+
+  uint64_t Next(size_t id) const { return consumers_[id].seq.load(std::memory_order_relaxed); }
+
+  const T& At(uint64_t seq) const { return slots_[seq & mask_]; }
+
+  // Hands n slots back to the producer at once.
+  void Release(size_t id, size_t n) {
+    uint64_t next = consumers_[id].seq.load(std::memory_order_relaxed);
+    consumers_[id].seq.store(next + n, std::memory_order_release);
+  }
+
+ private:
+  // one cursor per cache line, so consumers don't false-share
+  struct alignas(64) Cursor {
+    std::atomic<uint64_t> seq{0};
+  };
+
+  uint64_t MinConsumer() const {
+    uint64_t min = claimed_;
+    for (size_t i = 0; i < nconsumers_; ++i) {
+      uint64_t seq = consumers_[i].seq.load(std::memory_order_acquire);
+      if (seq < min) min = seq;
+    }
+    return min;
+  }
+
+  std::unique_ptr<T[]> slots_;
+  uint64_t mask_;
+
+  // producer private: next sequence to claim, and cached minimum consumer sequence
+  alignas(64) uint64_t claimed_ = 0;
+  uint64_t gate_ = 0;
+
+  Cursor cursor_;
+  std::atomic<bool> closed_{false};
+
+  size_t nconsumers_;
+  std::unique_ptr<Cursor[]> consumers_;
+};
+
+#endif  // BROADCAST_RING_H_
@@ -0,0 +1,58 @@
+#include "broadcast_ring.h"
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+struct Msg {
+  uint64_t seq;
+  uint64_t square;
+};
+
+int main() {
+  const size_t kConsumers = 3;
+  const uint64_t kMsgs = 1000000;
+
+  BroadcastRing<Msg> ring(1000, kConsumers);
+
+  std::vector<uint64_t> sum(kConsumers, 0);
+  std::vector<uint64_t> received(kConsumers, 0);
+  std::vector<std::thread> consumers;
+  for (size_t id = 0; id < kConsumers; ++id) {
+    consumers.emplace_back([&ring, &sum, &received, id] {
+      while (size_t n = ring.Wait(id)) {
+        uint64_t seq = ring.Next(id);
+        for (size_t i = 0; i < n; ++i) {
+          const Msg& msg = ring.At(seq + i);
+          // every consumer sees every message, in order
+          assert(msg.seq == seq + i);
+          assert(msg.square == msg.seq * msg.seq);
+          sum[id] += msg.seq;
+        }
+        received[id] += n;
+        ring.Release(id, n);
+      }
+    });
+  }
+
+  for (uint64_t i = 0; i < kMsgs; ++i) {
+    Msg& msg = ring.Claim();
+    msg.seq = i;
+    msg.square = i * i;
+    ring.Publish();
+  }
+  ring.Close();
+
+  for (auto& t : consumers) t.join();
+
+  for (size_t id = 0; id < kConsumers; ++id) {
+    assert(received[id] == kMsgs);
+    assert(sum[id] == kMsgs * (kMsgs - 1) / 2);
+  }
+
+  std::cout << "OK" << std::endl;
+  return 0;
+}
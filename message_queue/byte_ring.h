@@ -0,0 +1,149 @@
+#ifndef BYTE_RING_H_
+#define BYTE_RING_H_
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+
+// Multi-producer single-consumer ring of variable-length byte records. Producers reserve space,
+// write their payload in place and commit it; the consumer reads committed records in place and
+// releases them. Nothing is allocated per message and consecutive records are adjacent in memory.
+//
+// The buffer is mapped twice, back to back, so a record that runs past the end of the ring
+// continues at its beginning and is still contiguous in memory: there's no wrap-around padding.
+// Reservation is serialized by a short spin lock; the payload is written outside of it.
+//
+// Each record starts with an 8-byte header holding its payload size and a busy bit. A reserved
+// record is only published to the consumer with its busy bit set, and Commit() clears the bit, so
+// the consumer stops at the first record that is still being written.
+//
+// producer:
+//   if (void* buf = ring.Reserve(n)) {
+//     Fill(buf, n);
+//     ring.Commit(buf);
+//   }
+//
+// consumer:
+//   size_t n;
+//   while (const void* buf = ring.Peek(&n)) {
+//     Process(buf, n);
+//     ring.Release();
+//   }
+class ByteRing {
+ public:
+  ByteRing() = default;
+
+  ByteRing(const ByteRing& other) = delete;
+
+  ~ByteRing() {
+    if (base_) munmap(base_, 2 * capacity_);
+  }
+
+  ByteRing& operator=(const ByteRing& other) = delete;
+
+  // capacity is rounded up to a multiple of the page size
+  bool Create(size_t capacity) {
+    long pagesize = sysconf(_SC_PAGESIZE);
+    capacity = (capacity + pagesize - 1) / pagesize * pagesize;
+
+    int fd = memfd_create("byte_ring", 0);
+    if (fd < 0) return false;
+
+    if (ftruncate(fd, capacity) == 0) {
+      // reserve room for both mappings, then map the buffer over each half
+      void* base = mmap(nullptr, 2 * capacity, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (base != MAP_FAILED) {
+        char* lo = reinterpret_cast<char*>(base);
+        if (mmap(lo, capacity, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == lo &&
+            mmap(lo + capacity, capacity, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) ==
+                lo + capacity) {
+          close(fd);
+          base_ = lo;
+          capacity_ = capacity;
+          return true;
+        }
+        munmap(base, 2 * capacity);
+      }
+    }
+
+    close(fd);
+    return false;
+  }
+
+  // Producer. Returns size writable bytes, or nullptr if the ring doesn't have room right now.
+  void* Reserve(size_t size) {
+    size_t need = Align(kHeaderSize + size);
+    if (need > capacity_ || size > kSizeMask) return nullptr;
+
+    while (lock_.test_and_set(std::memory_order_acquire)) std::this_thread::yield();
+
+    uint64_t head = write_.load(std::memory_order_relaxed);
+    if (head + need - read_.load(std::memory_order_acquire) > capacity_) {
+      lock_.clear(std::memory_order_release);
+      return nullptr;
+    }
+
+    uint32_t* header = Header(head);
+    __atomic_store_n(header, static_cast<uint32_t>(size) | kBusy, __ATOMIC_RELAXED);
+    // publishes the busy header together with the new write position
+    write_.store(head + need, std::memory_order_release);
+
+    lock_.clear(std::memory_order_release);
+    return reinterpret_cast<char*>(header) + kHeaderSize;
+  }
+
+  // Producer. Publishes a record returned by Reserve().
+  void Commit(void* data) {
+    auto header = reinterpret_cast<uint32_t*>(reinterpret_cast<char*>(data) - kHeaderSize);
+    uint32_t size = __atomic_load_n(header, __ATOMIC_RELAXED) & kSizeMask;
+    __atomic_store_n(header, size, __ATOMIC_RELEASE);
+  }
+
+  // Consumer. Returns the oldest record if it has been committed, nullptr otherwise.
+  const void* Peek(size_t* size) const {
+    uint64_t tail = read_.load(std::memory_order_relaxed);
+    if (tail == write_.load(std::memory_order_acquire)) return nullptr;
+
+    uint32_t* header = Header(tail);
+    uint32_t word = __atomic_load_n(header, __ATOMIC_ACQUIRE);
+    if (word & kBusy) return nullptr;
+
+    *size = word;
+    return reinterpret_cast<char*>(header) + kHeaderSize;
+  }
+
+  // Consumer. Drops the record returned by the last Peek().
+  void Release() {
+    uint64_t tail = read_.load(std::memory_order_relaxed);
+    uint32_t size = __atomic_load_n(Header(tail), __ATOMIC_RELAXED);
+    read_.store(tail + Align(kHeaderSize + size), std::memory_order_release);
+  }
+
+  size_t Capacity() const { return capacity_; }
+
+ private:
+  static constexpr size_t kHeaderSize = 8;
+  static constexpr uint32_t kBusy = 1U << 31;
+  static constexpr uint32_t kSizeMask = kBusy - 1;
+
+  static size_t Align(size_t n) { return (n + 7) & ~static_cast<size_t>(7); }
+
+  uint32_t* Header(uint64_t pos) const {
+    return reinterpret_cast<uint32_t*>(base_ + pos % capacity_);
+  }
+
+  char* base_ = nullptr;
+  size_t capacity_ = 0;
+
+  std::atomic_flag lock_ = ATOMIC_FLAG_INIT;
+
+  // producer and consumer positions, on separate cache lines
+  alignas(64) std::atomic<uint64_t> write_{0};
+  alignas(64) std::atomic<uint64_t> read_{0};
+};
+
+#endif  // BYTE_RING_H_
@@ -1,10 +1,23 @@
 #ifndef MSGQUEUE_H_
 #define MSGQUEUE_H_
 
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <cstddef>
+#include <cstdint>
 #include <mutex>
 
+#include "msgspill.h"
+
+// Counters kept by a MsgQueue after EnableStats().
+struct MsgQueueStats {
+  size_t depth;          // messages currently queued, spilled ones included
+  size_t max_depth;      // high-water mark of depth
+  uint64_t put_wait_ns;  // total time producers were blocked on put_cond_ or put_mutex_
+  uint64_t get_wait_ns;  // total time consumers were blocked on get_cond_ or get_mutex_
+};
+
 class MsgQueue {
  public:
   MsgQueue(size_t maxlen, ptrdiff_t linkoff) : msg_max_(maxlen), linkoff_(linkoff) {
@@ -16,19 +29,112 @@ class MsgQueue {
   ~MsgQueue() {}
 
   void Put(void* msg) {
-    auto link = reinterpret_cast<void**>(reinterpret_cast<char*>(msg) + linkoff_);
+    PutLink(reinterpret_cast<void**>(reinterpret_cast<char*>(msg) + linkoff_));
+  }
+
+  void* Get() {
+    void** link = GetLink(true);
+    return link ? reinterpret_cast<char*>(link) - linkoff_ : nullptr;
+  }
+
+  // Like Get(), but returns nullptr instead of waiting for a producer.
+  void* TryGet() {
+    void** link = GetLink(false);
+    return link ? reinterpret_cast<char*>(link) - linkoff_ : nullptr;
+  }
+
+  void SetNonblock() {
+    // under the lock, or a consumer could check the flag and then miss the wakeup
+    std::lock_guard<std::mutex> put_lock(put_mutex_);
+    nonblock_ = true;
+    // unlock one consumer
+    get_cond_.notify_one();
+    // unlock all producers
+    put_cond_.notify_all();
+  }
+
+  void SetBlock() {
+    std::lock_guard<std::mutex> put_lock(put_mutex_);
+    nonblock_ = false;
+  }
+
+  // Overflow mode: messages beyond maxlen are serialized to spill instead of blocking producers,
+  // and are paged back in FIFO order once the in-memory messages are consumed. Serializing and
+  // creating segment files happen outside the queue's locks. If the spill can't take a message,
+  // e.g. on a full disk, producers block like without a spill until it has been paged in
+  // completely, so no message overtakes spilled ones; in nonblock mode the spill is moved to
+  // memory instead. Pass nullptr to turn it off again; spill must be empty by then.
+  void SetSpill(MsgSpill* spill) {
+    std::lock_guard<std::mutex> put_lock(put_mutex_);
+    spill_ = spill;
+    spill_refused_ = false;
+  }
+
+  // Starts keeping the counters, at the cost of a few atomic operations per Put() and Get() and
+  // clock reads around every wait. Call it before the first Put(), or depth is off.
+  void EnableStats() { stats_.store(true, std::memory_order_relaxed); }
+
+  MsgQueueStats GetStats() const {
+    return {depth_.load(std::memory_order_relaxed), max_depth_.load(std::memory_order_relaxed),
+            put_wait_ns_.load(std::memory_order_relaxed),
+            get_wait_ns_.load(std::memory_order_relaxed)};
+  }
+
+ protected:
+  // Put()/Get() on the link field itself, for wrappers that know linkoff_ at compile time.
+  void PutLink(void** link) {
     *link = nullptr;
+    void* msg = reinterpret_cast<char*>(link) - linkoff_;
 
     // lock producer
-    std::unique_lock<std::mutex> put_lock(put_mutex_);
+    std::unique_lock<std::mutex> put_lock(put_mutex_, std::defer_lock);
+    Lock(put_lock, put_wait_ns_);
+
+    // Once anything has been spilled, keep spilling until the spill drains, so order is kept.
+    while (spill_ && !spill_refused_ && (msg_cnt_ >= msg_max_ || spill_->Count() > 0)) {
+      MsgSpill* spill = spill_;
+      size_t size = spill->Size(msg);
+      // The reservation fixes the message's place, the bytes are written without the lock.
+      if (void* rec = spill->Reserve(size)) {
+        put_lock.unlock();
+        spill->Encode(msg, rec, size);
+        put_lock.lock();
+        spill->Commit(rec);
+        CountPut();
+        put_lock.unlock();
+        get_cond_.notify_one();
+        return;
+      }
 
-    while (msg_cnt_ >= msg_max_ && !nonblock_) {
-      put_cond_.wait(put_lock);
+      // no room, make the next segment without the lock and try again
+      put_lock.unlock();
+      MsgSpill::Segment* seg = spill->NewSegment(size);
+      put_lock.lock();
+      if (!seg) {
+        // Stop spilling until the spill has drained, or it might never drain.
+        spill_refused_ = SpillCount() > 0;
+        break;
+      }
+      spill->AddSegment(seg);
     }
 
+    // The message must not go to memory ahead of older spilled ones. Waiting for one drain is
+    // enough, anything spilled after it comes from other producers.
+    if (spill_refused_) {
+      uint64_t drains = spill_drains_;
+      while (spill_drains_ == drains && !nonblock_) WaitPut(put_lock);
+      if (spill_drains_ == drains) {
+        SpillToPutList();
+        SpillDrained();
+      }
+    }
+
+    while (msg_cnt_ >= msg_max_ && !nonblock_) WaitPut(put_lock);
+
     *put_tail_ = link;
     put_tail_ = link;
     ++msg_cnt_;
+    CountPut();
 
     // unlock producer
     put_lock.unlock();
@@ -36,45 +142,36 @@ class MsgQueue {
     get_cond_.notify_one();
   }
 
-  void* Get() {
-    void* msg;
+  void** GetLink(bool block) {
+    void** link;
 
     // lock consumer
-    std::unique_lock<std::mutex> get_lock(get_mutex_);
+    std::unique_lock<std::mutex> get_lock(get_mutex_, std::defer_lock);
+    Lock(get_lock, get_wait_ns_);
 
-    if (*get_head_ || MsgQueueSwap() > 0) {
-      msg = reinterpret_cast<char*>(*get_head_) - linkoff_;
-      *get_head_ = *reinterpret_cast<void**>(*get_head_);
+    if (*get_head_ || MsgQueueSwap(block) > 0) {
+      link = reinterpret_cast<void**>(*get_head_);
+      *get_head_ = *link;
+      CountGet();
     } else {
-      msg = nullptr;
+      link = nullptr;
     }
 
     // unlock consumer and return
-    return msg;
+    return link;
   }
 
-  void SetNonblock() {
-    nonblock_ = true;
-    std::lock_guard<std::mutex> put_lock(put_mutex_);
-    // unlock one consumer
-    get_cond_.notify_one();
-    // unlock all producers
-    put_cond_.notify_all();
-  }
-
-  void SetBlock() { nonblock_ = false; }
-
  private:
   // consumer has been locked
-  size_t MsgQueueSwap() {
+  size_t MsgQueueSwap(bool block) {
     void** get_head = get_head_;
     get_head_ = put_head_;
 
     // lock producer
     std::unique_lock<std::mutex> put_lock(put_mutex_);
 
-    while (msg_cnt_ == 0 && !nonblock_) {
-      get_cond_.wait(put_lock);
+    while (msg_cnt_ == 0 && !SpillReady() && block && !nonblock_) {
+      Wait(get_cond_, put_lock, get_wait_ns_);
     }
 
     size_t cnt = msg_cnt_;
@@ -85,14 +182,117 @@ class MsgQueue {
     put_tail_ = get_head;
     msg_cnt_ = 0;
 
+    // Everything in memory is older than the spill, so only page in once memory is empty.
+    if (cnt == 0 && SpillCount() > 0) {
+      cnt = PageIn();
+      SpillDrained();
+    }
+
     // unlock producer and return
     return cnt;
   }
 
+  // producer has been locked, consumer list is empty
+  size_t PageIn() {
+    // at least one, or a queue with maxlen 0 would never drain its spill
+    size_t batch = msg_max_ < 1 ? 1 : msg_max_ < kPageInMax ? msg_max_ : kPageInMax;
+    void** tail = get_head_;
+    size_t cnt = 0;
+
+    while (cnt < batch) {
+      void* msg = spill_->Pop();
+      if (!msg) break;
+
+      auto link = reinterpret_cast<void**>(reinterpret_cast<char*>(msg) + linkoff_);
+      *link = nullptr;
+      *tail = link;
+      tail = link;
+      ++cnt;
+    }
+
+    return cnt;
+  }
+
+  // producer has been locked, nonblock mode: appends the spill to the producer list, which
+  // everything in the spill is newer than, up to a message another producer is still encoding
+  void SpillToPutList() {
+    while (void* msg = spill_->Pop()) {
+      auto link = reinterpret_cast<void**>(reinterpret_cast<char*>(msg) + linkoff_);
+      *link = nullptr;
+      *put_tail_ = link;
+      put_tail_ = link;
+      ++msg_cnt_;
+    }
+  }
+
+  size_t SpillCount() const { return spill_ ? spill_->Count() : 0; }
+
+  bool SpillReady() { return spill_ && spill_->Ready(); }
+
+  // producer has been locked: wakes the producers the spill refused once it is empty, and lets
+  // the spill be tried again
+  void SpillDrained() {
+    if (spill_refused_ && SpillCount() == 0) {
+      spill_refused_ = false;
+      ++spill_drains_;
+      put_cond_.notify_all();
+    }
+  }
+
+  // producer has been locked
+  void WaitPut(std::unique_lock<std::mutex>& put_lock) { Wait(put_cond_, put_lock, put_wait_ns_); }
+
+  void Lock(std::unique_lock<std::mutex>& lock, std::atomic<uint64_t>& wait_ns) {
+    if (!stats_.load(std::memory_order_relaxed)) {
+      lock.lock();
+    } else if (!lock.try_lock()) {
+      uint64_t start = NowNs();
+      lock.lock();
+      wait_ns.fetch_add(NowNs() - start, std::memory_order_relaxed);
+    }
+  }
+
+  void Wait(std::condition_variable& cond, std::unique_lock<std::mutex>& lock,
+            std::atomic<uint64_t>& wait_ns) {
+    if (!stats_.load(std::memory_order_relaxed)) {
+      cond.wait(lock);
+      return;
+    }
+    uint64_t start = NowNs();
+    cond.wait(lock);
+    wait_ns.fetch_add(NowNs() - start, std::memory_order_relaxed);
+  }
+
+  static uint64_t NowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+  }
+
+  void CountPut() {
+    if (!stats_.load(std::memory_order_relaxed)) return;
+    size_t depth = depth_.fetch_add(1, std::memory_order_relaxed) + 1;
+    size_t max_depth = max_depth_.load(std::memory_order_relaxed);
+    while (depth > max_depth &&
+           !max_depth_.compare_exchange_weak(max_depth, depth, std::memory_order_relaxed)) {
+    }
+  }
+
+  void CountGet() {
+    if (stats_.load(std::memory_order_relaxed)) depth_.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  // bounds how many paged-in messages sit in memory at once
+  static constexpr size_t kPageInMax = 256;
+
   size_t msg_max_;
   size_t msg_cnt_ = 0;
   ptrdiff_t linkoff_;
   bool nonblock_ = false;
+  MsgSpill* spill_ = nullptr;
+  // the spill failed to make a segment, producers wait for it to drain
+  bool spill_refused_ = false;
+  uint64_t spill_drains_ = 0;
 
   // helper nodes
   void* head1_ = nullptr;
@@ -106,6 +306,12 @@ class MsgQueue {
   std::mutex put_mutex_;
   std::condition_variable get_cond_;
   std::condition_variable put_cond_;
+
+  std::atomic<bool> stats_{false};
+  std::atomic<size_t> depth_{0};
+  std::atomic<size_t> max_depth_{0};
+  std::atomic<uint64_t> put_wait_ns_{0};
+  std::atomic<uint64_t> get_wait_ns_{0};
 };
 
 #endif  // MSGQUEUE_H_
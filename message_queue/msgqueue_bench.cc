@@ -0,0 +1,110 @@
+// MsgQueue under contention: sweeps producers, consumers, maxlen and message size, and reports
+// throughput and end-to-end latency percentiles. A second argument of 1 also reports the queue's
+// own depth and wait counters, which cost some throughput.
+//   g++ -std=c++17 -O2 -pthread msgqueue_bench.cc -o msgqueue_bench
+//   ./msgqueue_bench [messages per run] [stats]
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "msgqueue.h"
+
+// allocated with the payload right behind it
+struct BenchMsg {
+  void* link;
+  uint64_t sent_ns;
+
+  char* Payload() { return reinterpret_cast<char*>(this + 1); }
+};
+
+static uint64_t NowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+static void RunOnce(size_t nproducers, size_t nconsumers, size_t maxlen, size_t msgsize,
+                    size_t nmsgs, bool stats) {
+  MsgQueue mq(maxlen, offsetof(BenchMsg, link));
+  if (stats) mq.EnableStats();
+  size_t per_producer = nmsgs / nproducers;
+
+  std::vector<std::vector<uint64_t>> latencies(nconsumers);
+  std::vector<std::thread> consumers;
+  for (size_t c = 0; c < nconsumers; ++c) {
+    latencies[c].reserve(nmsgs / nconsumers * 2);
+    consumers.emplace_back([&mq, &latencies, c] {
+      while (auto msg = reinterpret_cast<BenchMsg*>(mq.Get())) {
+        latencies[c].push_back(NowNs() - msg->sent_ns);
+        free(msg);
+      }
+    });
+  }
+
+  uint64_t start = NowNs();
+  std::vector<std::thread> producers;
+  for (size_t p = 0; p < nproducers; ++p) {
+    producers.emplace_back([&mq, per_producer, msgsize] {
+      for (size_t i = 0; i < per_producer; ++i) {
+        auto msg = reinterpret_cast<BenchMsg*>(malloc(sizeof(BenchMsg) + msgsize));
+        memset(msg->Payload(), static_cast<int>(i), msgsize);
+        msg->sent_ns = NowNs();
+        mq.Put(msg);
+      }
+    });
+  }
+
+  for (auto& t : producers) t.join();
+  // consumers return once the queue is drained
+  mq.SetNonblock();
+  for (auto& t : consumers) t.join();
+  uint64_t elapsed = NowNs() - start;
+
+  std::vector<uint64_t> all;
+  for (auto& l : latencies) all.insert(all.end(), l.begin(), l.end());
+  std::sort(all.begin(), all.end());
+  auto percentile = [&all](double p) {
+    return all.empty() ? 0 : all[static_cast<size_t>(p * (all.size() - 1))];
+  };
+
+  printf("%4zu %4zu %10zd %6zu %12.0f %10lu %10lu %10lu", nproducers, nconsumers,
+         static_cast<ptrdiff_t>(maxlen), msgsize, all.size() * 1e9 / elapsed,
+         static_cast<unsigned long>(percentile(0.5)), static_cast<unsigned long>(percentile(0.99)),
+         static_cast<unsigned long>(percentile(0.999)));
+  if (stats) {
+    MsgQueueStats counters = mq.GetStats();
+    printf(" %8zu %11.2f %11.2f", counters.max_depth, counters.put_wait_ns / 1e6,
+           counters.get_wait_ns / 1e6);
+  }
+  printf("\n");
+}
+
+int main(int argc, char* argv[]) {
+  size_t nmsgs = argc > 1 ? strtoul(argv[1], nullptr, 10) : 200000;
+  bool stats = argc > 2 && atoi(argv[2]) != 0;
+
+  printf("%4s %4s %10s %6s %12s %10s %10s %10s", "prod", "cons", "maxlen", "size", "msgs/s",
+         "p50(ns)", "p99(ns)", "p999(ns)");
+  if (stats) printf(" %8s %11s %11s", "maxdepth", "putwait(ms)", "getwait(ms)");
+  printf("\n");
+
+  for (size_t nproducers : {1, 2, 4, 8}) {
+    for (size_t nconsumers : {1, 2, 4}) {
+      for (size_t maxlen : {static_cast<size_t>(16), static_cast<size_t>(1024),
+                            static_cast<size_t>(-1)}) {
+        for (size_t msgsize : {16, 256, 4096}) {
+          RunOnce(nproducers, nconsumers, maxlen, msgsize, nmsgs, stats);
+        }
+      }
+    }
+  }
+
+  return 0;
+}
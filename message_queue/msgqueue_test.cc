@@ -2,6 +2,7 @@
 
 #include <cassert>
 #include <cstddef>
+#include <cstring>
 #include <iostream>
 #include <type_traits>
 
@@ -66,6 +67,16 @@ int main() {
   auto msg_out2 = reinterpret_cast<Msg1*>(mq.Get());
   PrintMsg(msg_out2);
   assert(msg_out2 == nullptr);
+  delete msg_in1;
+
+  // counters are kept once enabled
+  MsgQueue counted(10, linkoff);
+  counted.EnableStats();
+  Msg1 msgs[3];
+  for (Msg1& msg : msgs) counted.Put(&msg);
+  assert(counted.Get() == &msgs[0]);
+  MsgQueueStats stats = counted.GetStats();
+  assert(stats.depth == 2 && stats.max_depth == 3);
 
   return 0;
 }
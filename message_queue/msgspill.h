@@ -0,0 +1,230 @@
+#ifndef MSGSPILL_H_
+#define MSGSPILL_H_
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+// How a spilled message is turned into bytes and back.
+struct MsgSpillOps {
+  // bytes needed to serialize msg
+  size_t (*size)(const void* msg);
+  // serialize msg into buf and release msg
+  void (*encode)(void* msg, void* buf);
+  // rebuild a message from the bytes written by encode
+  void* (*decode)(const void* buf, size_t size);
+};
+
+// FIFO of serialized messages stored in append-only memory-mapped segment files. Segment files
+// are unlinked as soon as they are created, so nothing is left behind on disk after a crash, and
+// a segment is unmapped as soon as it has been read to the end.
+//
+// Not thread safe on its own: the owner (MsgQueue) serializes Reserve(), Commit(), AddSegment(),
+// Pop(), Ready() and Count() with its lock. The slow parts, NewSegment() and Encode(), need no
+// lock, so a message is spilled as
+//   under the lock:  rec = Reserve(size), or NewSegment() without it and AddSegment() if full
+//   without it:      Encode(msg, rec, size)
+//   under the lock:  Commit(rec)
+// The record's place in the FIFO is fixed by Reserve(); Pop() stops at it until it is committed.
+class MsgSpill {
+ public:
+  struct Segment {
+    char* base;
+    size_t size;
+    size_t write_off;
+    size_t read_off;
+    Segment* next;
+  };
+
+  MsgSpill() = default;
+
+  MsgSpill(const MsgSpill& other) = delete;
+
+  ~MsgSpill() {
+    while (head_) {
+      Segment* next = head_->next;
+      Release(head_);
+      head_ = next;
+    }
+    while (spare_) {
+      Segment* next = spare_->next;
+      Release(spare_);
+      spare_ = next;
+    }
+  }
+
+  MsgSpill& operator=(const MsgSpill& other) = delete;
+
+  bool Open(const char* dir, size_t segsize, const MsgSpillOps& ops) {
+    long pagesize = sysconf(_SC_PAGESIZE);
+    dir_ = dir;
+    segsize_ = (segsize + pagesize - 1) / pagesize * pagesize;
+    ops_ = ops;
+    return segsize_ > 0 && ops_.size && ops_.encode && ops_.decode;
+  }
+
+  // Serialize msg to the tail segment. On failure msg is left untouched.
+  bool Push(void* msg) {
+    size_t size = Size(msg);
+    void* rec = Reserve(size);
+    if (!rec) {
+      Segment* seg = NewSegment(size);
+      if (!seg) return false;
+      AddSegment(seg);
+      rec = Reserve(size);
+    }
+    Encode(msg, rec, size);
+    Commit(rec);
+    return true;
+  }
+
+  size_t Size(const void* msg) const { return ops_.size(msg); }
+
+  // Space for a record of size bytes at the tail, or nullptr if neither the tail segment nor a
+  // spare one has room. Counts the message already.
+  void* Reserve(size_t size) {
+    size_t need = Align(sizeof(uint64_t) + size);
+
+    if (!tail_ || tail_->write_off + need > tail_->size) {
+      Segment** spare = &spare_;
+      while (*spare && (*spare)->size < need) spare = &(*spare)->next;
+      if (!*spare) return nullptr;
+
+      Segment* seg = *spare;
+      *spare = seg->next;
+      seg->next = nullptr;
+      if (tail_)
+        tail_->next = seg;
+      else
+        head_ = seg;
+      tail_ = seg;
+    }
+
+    char* rec = tail_->base + tail_->write_off;
+    tail_->write_off += need;
+    ++count_;
+    reserved_.push_back(rec);
+    return rec;
+  }
+
+  // Serializes msg into a record from Reserve() and releases msg.
+  void Encode(void* msg, void* rec, size_t size) const {
+    *reinterpret_cast<uint64_t*>(rec) = size;
+    ops_.encode(msg, reinterpret_cast<char*>(rec) + sizeof(uint64_t));
+  }
+
+  // Makes an encoded record visible to Pop().
+  void Commit(void* rec) {
+    for (size_t i = 0; i < reserved_.size(); ++i) {
+      if (reserved_[i] == rec) {
+        reserved_[i] = reserved_.back();
+        reserved_.pop_back();
+        return;
+      }
+    }
+  }
+
+  // A new segment with room for a record of size bytes, or nullptr if the file can't be made.
+  // Only reads what Open() set.
+  Segment* NewSegment(size_t size) const {
+    size_t need = Align(sizeof(uint64_t) + size);
+    return Create(need > segsize_ ? need : segsize_);
+  }
+
+  // Keeps seg from NewSegment() as a spare for Reserve().
+  void AddSegment(Segment* seg) {
+    seg->next = spare_;
+    spare_ = seg;
+  }
+
+  // Deserialize the oldest message, or return nullptr if the spill is empty or the oldest
+  // message is not committed yet.
+  void* Pop() {
+    if (!Ready()) return nullptr;
+
+    char* rec = head_->base + head_->read_off;
+    size_t size = *reinterpret_cast<uint64_t*>(rec);
+    void* msg = ops_.decode(rec + sizeof(uint64_t), size);
+
+    head_->read_off += Align(sizeof(uint64_t) + size);
+    if (--count_ == 0) {
+      // fully drained, start over at the beginning of the last segment
+      while (head_ != tail_) {
+        Segment* next = head_->next;
+        Release(head_);
+        head_ = next;
+      }
+      head_->read_off = 0;
+      head_->write_off = 0;
+    }
+    return msg;
+  }
+
+  // whether Pop() returns a message
+  bool Ready() {
+    if (count_ == 0) return false;
+
+    while (head_->read_off == head_->write_off) {
+      Segment* next = head_->next;
+      Release(head_);
+      head_ = next;
+    }
+
+    const char* rec = head_->base + head_->read_off;
+    for (const char* reserved : reserved_) {
+      if (reserved == rec) return false;
+    }
+    return true;
+  }
+
+  // messages spilled and not popped yet, reserved ones included
+  size_t Count() const { return count_; }
+
+ private:
+  static size_t Align(size_t n) { return (n + 7) & ~static_cast<size_t>(7); }
+
+  Segment* Create(size_t size) const {
+    std::string path = dir_ + "/msgspill-XXXXXX";
+    int fd = mkstemp(&path[0]);
+    if (fd < 0) return nullptr;
+
+    unlink(path.c_str());
+
+    // Allocate the blocks now: a store to a hole in a sparse file on a full disk is a SIGBUS.
+    void* base = MAP_FAILED;
+    if (posix_fallocate(fd, 0, size) == 0) {
+      base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    // the mapping keeps the file alive
+    close(fd);
+    if (base == MAP_FAILED) return nullptr;
+
+    return new Segment{reinterpret_cast<char*>(base), size, 0, 0, nullptr};
+  }
+
+  void Release(Segment* seg) {
+    munmap(seg->base, seg->size);
+    if (seg == tail_) tail_ = nullptr;
+    delete seg;
+  }
+
+  std::string dir_;
+  size_t segsize_ = 0;
+  MsgSpillOps ops_{};
+
+  size_t count_ = 0;
+  Segment* head_ = nullptr;
+  Segment* tail_ = nullptr;
+  // made by NewSegment(), not in use yet
+  Segment* spare_ = nullptr;
+  // reserved and not committed yet, at most one per producer
+  std::vector<const char*> reserved_;
+};
+
+#endif  // MSGSPILL_H_
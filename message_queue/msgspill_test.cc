@@ -0,0 +1,195 @@
+#include "msgspill.h"
+
+#include <unistd.h>
+
+#include <cassert>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "msgqueue.h"
+
+struct Msg {
+  size_t seq;
+  char payload[32];
+  void* link;
+};
+
+size_t MsgSize(const void*) { return sizeof(Msg); }
+
+void MsgEncode(void* msg, void* buf) {
+  memcpy(buf, msg, sizeof(Msg));
+  delete reinterpret_cast<Msg*>(msg);
+}
+
+void* MsgDecode(const void* buf, size_t size) {
+  assert(size == sizeof(Msg));
+  auto msg = new Msg;
+  memcpy(msg, buf, sizeof(Msg));
+  return msg;
+}
+
+void TestMsgSpill() {
+  MsgSpill spill;
+  // tiny segments, so that records cross many segment files
+  bool ok = spill.Open("/tmp", 1, {MsgSize, MsgEncode, MsgDecode});
+  assert(ok);
+
+  for (size_t i = 0; i < 1000; ++i) {
+    auto msg = new Msg{i, "spilled", nullptr};
+    ok = spill.Push(msg);
+    assert(ok);
+  }
+  assert(spill.Count() == 1000);
+
+  for (size_t i = 0; i < 1000; ++i) {
+    auto msg = reinterpret_cast<Msg*>(spill.Pop());
+    assert(msg && msg->seq == i);
+    assert(strcmp(msg->payload, "spilled") == 0);
+    delete msg;
+  }
+  assert(spill.Count() == 0);
+  assert(spill.Pop() == nullptr);
+}
+
+void TestMsgQueueSpill() {
+  const size_t kMsgs = 100000;
+
+  MsgSpill spill;
+  bool ok = spill.Open("/tmp", 1 << 20, {MsgSize, MsgEncode, MsgDecode});
+  assert(ok);
+
+  MsgQueue mq(16, offsetof(Msg, link));
+  mq.SetSpill(&spill);
+
+  // the producer never blocks, even though nobody consumes yet
+  for (size_t i = 0; i < kMsgs / 2; ++i) mq.Put(new Msg{i, "", nullptr});
+  assert(spill.Count() > 0);
+
+  std::thread producer([&mq, kMsgs] {
+    for (size_t i = kMsgs / 2; i < kMsgs; ++i) mq.Put(new Msg{i, "", nullptr});
+  });
+
+  for (size_t i = 0; i < kMsgs; ++i) {
+    auto msg = reinterpret_cast<Msg*>(mq.Get());
+    assert(msg && msg->seq == i);
+    delete msg;
+  }
+
+  producer.join();
+  mq.SetNonblock();
+  assert(mq.Get() == nullptr);
+  assert(spill.Count() == 0);
+}
+
+// Once the spill refuses a message, that message must still come after the spilled ones: in
+// blocking mode its producer waits for the spill to drain, in nonblock mode the spill is moved
+// to memory first.
+void TestSpillRefused() {
+  for (bool nonblock : {false, true}) {
+    char dir[] = "/tmp/msgspill-test-XXXXXX";
+    bool ok = mkdtemp(dir) != nullptr;
+    assert(ok);
+
+    MsgSpill spill;
+    ok = spill.Open(dir, 1, {MsgSize, MsgEncode, MsgDecode});
+    assert(ok);
+    MsgQueue mq(4, offsetof(Msg, link));
+    mq.SetSpill(&spill);
+
+    // 4 in memory and a few in the first spill segment
+    size_t seq = 0;
+    for (; seq < 20; ++seq) mq.Put(new Msg{seq, "", nullptr});
+    assert(spill.Count() == 16);
+
+    // segment files are unlinked already, so the directory can go and no segment can be added
+    ok = rmdir(dir) == 0;
+    assert(ok);
+
+    const size_t kMsgs = 1000;
+    std::thread producer([&mq, seq, kMsgs]() mutable {
+      for (; seq < kMsgs; ++seq) mq.Put(new Msg{seq, "", nullptr});
+    });
+    if (nonblock) {
+      mq.SetNonblock();
+      producer.join();
+    }
+
+    for (size_t i = 0; i < kMsgs; ++i) {
+      auto msg = reinterpret_cast<Msg*>(mq.Get());
+      assert(msg && msg->seq == i);
+      delete msg;
+    }
+    if (!nonblock) producer.join();
+    assert(spill.Count() == 0);
+    mq.SetSpill(nullptr);
+  }
+}
+
+// Producers reserve, encode and add segments concurrently; each one's messages stay in order.
+void TestSpillProducers() {
+  const size_t kProducers = 4;
+  const size_t kMsgs = 20000;
+
+  MsgSpill spill;
+  // one page per segment, so producers often race to add the next one
+  bool ok = spill.Open("/tmp", 1, {MsgSize, MsgEncode, MsgDecode});
+  assert(ok);
+  MsgQueue mq(16, offsetof(Msg, link));
+  mq.SetSpill(&spill);
+
+  std::vector<std::thread> producers;
+  for (size_t p = 0; p < kProducers; ++p) {
+    producers.emplace_back([&mq, p, kMsgs] {
+      for (size_t i = 0; i < kMsgs; ++i) {
+        auto msg = new Msg{i, "", nullptr};
+        msg->payload[0] = static_cast<char>(p);
+        mq.Put(msg);
+      }
+    });
+  }
+
+  std::vector<size_t> next(kProducers, 0);
+  for (size_t i = 0; i < kProducers * kMsgs; ++i) {
+    auto msg = reinterpret_cast<Msg*>(mq.Get());
+    assert(msg);
+    size_t p = static_cast<size_t>(msg->payload[0]);
+    assert(p < kProducers && msg->seq == next[p]);
+    ++next[p];
+    delete msg;
+  }
+
+  for (std::thread& producer : producers) producer.join();
+  assert(spill.Count() == 0);
+}
+
+// With maxlen 0 every message is spilled, and paging in must still make progress.
+void TestZeroMaxlen() {
+  MsgSpill spill;
+  bool ok = spill.Open("/tmp", 1, {MsgSize, MsgEncode, MsgDecode});
+  assert(ok);
+  MsgQueue mq(0, offsetof(Msg, link));
+  mq.SetSpill(&spill);
+
+  for (size_t i = 0; i < 100; ++i) mq.Put(new Msg{i, "", nullptr});
+  assert(spill.Count() == 100);
+  for (size_t i = 0; i < 100; ++i) {
+    auto msg = reinterpret_cast<Msg*>(mq.TryGet());
+    assert(msg && msg->seq == i);
+    delete msg;
+  }
+  assert(mq.TryGet() == nullptr);
+}
+
+int main() {
+  TestMsgSpill();
+  TestMsgQueueSpill();
+  TestSpillRefused();
+  TestSpillProducers();
+  TestZeroMaxlen();
+  std::cout << "OK" << std::endl;
+  return 0;
+}
@@ -0,0 +1,137 @@
+#ifndef SHARDED_MSGQUEUE_H_
+#define SHARDED_MSGQUEUE_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "msgqueue.h"
+
+// N independent MsgQueues behind one interface, so producers no longer serialize on a single
+// put_mutex_. A producer puts into the less loaded of two randomly chosen shards
+// (power-of-two-choices); a consumer drains its home shard first and then scans the others.
+// Messages are FIFO within a shard, and the load balancing keeps shards roughly level, so the
+// global order is FIFO-ish.
+class ShardedMsgQueue {
+ public:
+  // maxlen is split evenly among the shards.
+  ShardedMsgQueue(size_t nshards, size_t maxlen, ptrdiff_t linkoff)
+      : nshards_(nshards > 0 ? nshards : 1) {
+    size_t shard_max = maxlen / nshards_ > 0 ? maxlen / nshards_ : 1;
+    shards_.reserve(nshards_);
+    for (size_t i = 0; i < nshards_; ++i) {
+      shards_.emplace_back(new Shard(shard_max, linkoff));
+    }
+  }
+
+  ~ShardedMsgQueue() {}
+
+  void Put(void* msg) {
+    Shard* shard = PickShard();
+
+    // Count the message before it is visible, so concurrent producers already see the load.
+    shard->load.fetch_add(1, std::memory_order_relaxed);
+    shard->queue.Put(msg);
+
+    msg_cnt_.fetch_add(1);
+    // Pairs with the waiters_ increment in Get(): either we see the waiter or it sees the message.
+    if (waiters_.load() > 0) {
+      std::lock_guard<std::mutex> wait_lock(wait_mutex_);
+      wait_cond_.notify_one();
+    }
+  }
+
+  void* Get() {
+    size_t home = HomeShard();
+
+    while (true) {
+      for (size_t i = 0; i < nshards_; ++i) {
+        Shard* shard = shards_[(home + i) % nshards_].get();
+        if (shard->load.load(std::memory_order_relaxed) == 0) continue;
+
+        void* msg = shard->queue.TryGet();
+        if (msg) {
+          shard->load.fetch_sub(1, std::memory_order_relaxed);
+          msg_cnt_.fetch_sub(1);
+          return msg;
+        }
+      }
+
+      // nothing found, sleep until a producer publishes
+      std::unique_lock<std::mutex> wait_lock(wait_mutex_);
+      waiters_.fetch_add(1);
+      while (msg_cnt_.load() <= 0 && !nonblock_) {
+        wait_cond_.wait(wait_lock);
+      }
+      waiters_.fetch_sub(1);
+
+      if (msg_cnt_.load() <= 0) return nullptr;
+    }
+  }
+
+  void SetNonblock() {
+    nonblock_ = true;
+    // unlock all producers
+    for (auto& shard : shards_) shard->queue.SetNonblock();
+    std::lock_guard<std::mutex> wait_lock(wait_mutex_);
+    // unlock all consumers
+    wait_cond_.notify_all();
+  }
+
+  void SetBlock() {
+    for (auto& shard : shards_) shard->queue.SetBlock();
+    nonblock_ = false;
+  }
+
+ private:
+  // Each shard sits on its own cache lines so that the load counters don't false-share.
+  struct alignas(64) Shard {
+    Shard(size_t maxlen, ptrdiff_t linkoff) : queue(maxlen, linkoff) {}
+
+    MsgQueue queue;
+    std::atomic<size_t> load{0};
+  };
+
+  static uint64_t Random() {
+    // xorshift64, seeded per thread
+    static std::atomic<uint64_t> seed{0x9e3779b97f4a7c15ULL};
+    thread_local uint64_t x = seed.fetch_add(0x9e3779b97f4a7c15ULL) | 1;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return x;
+  }
+
+  size_t HomeShard() const {
+    static std::atomic<size_t> next{0};
+    thread_local size_t home = next.fetch_add(1);
+    return home % nshards_;
+  }
+
+  Shard* PickShard() {
+    if (nshards_ == 1) return shards_[0].get();
+
+    uint64_t r = Random();
+    Shard* a = shards_[(r & 0xffffffff) % nshards_].get();
+    Shard* b = shards_[(r >> 32) % nshards_].get();
+    return b->load.load(std::memory_order_relaxed) < a->load.load(std::memory_order_relaxed) ? b
+                                                                                             : a;
+  }
+
+  size_t nshards_;
+  std::vector<std::unique_ptr<Shard>> shards_;
+
+  // Signed, because a consumer may take a message before its producer has counted it.
+  std::atomic<ptrdiff_t> msg_cnt_{0};
+  std::atomic<size_t> waiters_{0};
+  std::atomic<bool> nonblock_{false};
+
+  std::mutex wait_mutex_;
+  std::condition_variable wait_cond_;
+};
+
+#endif  // SHARDED_MSGQUEUE_H_
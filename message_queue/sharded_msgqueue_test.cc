@@ -0,0 +1,57 @@
+#include "sharded_msgqueue.h"
+
+#include <cassert>
+#include <cstddef>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+struct Msg {
+  size_t producer;
+  size_t seq;
+  void* link;
+};
+
+int main() {
+  const size_t kProducers = 4;
+  const size_t kConsumers = 4;
+  const size_t kMsgs = 100000;
+
+  ShardedMsgQueue mq(4, 1024, offsetof(Msg, link));
+
+  std::vector<std::thread> producers;
+  for (size_t p = 0; p < kProducers; ++p) {
+    producers.emplace_back([&mq, p, kMsgs] {
+      for (size_t i = 0; i < kMsgs; ++i) mq.Put(new Msg{p, i, nullptr});
+    });
+  }
+
+  std::vector<size_t> received(kConsumers, 0);
+  std::vector<size_t> sum(kConsumers, 0);
+  std::vector<std::thread> consumers;
+  for (size_t c = 0; c < kConsumers; ++c) {
+    consumers.emplace_back([&mq, &received, &sum, c] {
+      while (auto msg = reinterpret_cast<Msg*>(mq.Get())) {
+        ++received[c];
+        sum[c] += msg->seq;
+        delete msg;
+      }
+    });
+  }
+
+  for (auto& t : producers) t.join();
+  mq.SetNonblock();
+  for (auto& t : consumers) t.join();
+
+  size_t total = 0, total_sum = 0;
+  for (size_t c = 0; c < kConsumers; ++c) {
+    total += received[c];
+    total_sum += sum[c];
+  }
+  assert(total == kProducers * kMsgs);
+  assert(total_sum == kProducers * (kMsgs * (kMsgs - 1) / 2));
+  assert(mq.Get() == nullptr);
+
+  std::cout << "OK" << std::endl;
+  return 0;
+}
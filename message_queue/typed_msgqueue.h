@@ -0,0 +1,78 @@
+#ifndef TYPED_MSGQUEUE_H_
+#define TYPED_MSGQUEUE_H_
+
+#include <cstddef>
+#include <type_traits>
+
+#include "msgqueue.h"
+
+// MsgQueue for one message type whose link field is known at compile time:
+//   TypedMsgQueue<Msg, &Msg::link> mq(maxlen);
+//   mq.Put(msg);
+//   Msg* msg = mq.Get();
+// Put() and Get() work on the link field directly, so the link offset is a compile-time constant
+// instead of being loaded from linkoff_ on every call, and callers don't reinterpret_cast.
+
+namespace typed_msgqueue_internal {
+
+// offsetof() for a member pointer, found by comparing the member's address on a constant probe
+// object with the address of each of its bytes
+template <typename T, void* T::*Link>
+struct LinkOffset {
+  union Probe {
+    constexpr Probe() : bytes() {}
+    char bytes[sizeof(T)];
+    T object;
+  };
+
+  static constexpr Probe kProbe{};
+
+  static constexpr ptrdiff_t Find() {
+    const void* link = &(kProbe.object.*Link);
+    for (size_t i = 0; i < sizeof(T); ++i) {
+      if (link == &kProbe.bytes[i]) return static_cast<ptrdiff_t>(i);
+    }
+    return -1;
+  }
+
+  static constexpr ptrdiff_t kValue = Find();
+};
+
+}  // namespace typed_msgqueue_internal
+
+template <typename T, void* T::*Link>
+class TypedMsgQueue : private MsgQueue {
+  // the offset of the link field is only meaningful for standard layout types
+  static_assert(std::is_standard_layout<T>::value, "message type must be standard layout");
+  // the probe object for the offset must be a constant
+  static_assert(std::is_trivially_destructible<T>::value,
+                "message type must be trivially destructible");
+
+  static constexpr ptrdiff_t kLinkOffset = typed_msgqueue_internal::LinkOffset<T, Link>::kValue;
+  static_assert(kLinkOffset >= 0 && kLinkOffset + sizeof(void*) <= sizeof(T),
+                "link must be a field of the message type");
+
+ public:
+  explicit TypedMsgQueue(size_t maxlen) : MsgQueue(maxlen, kLinkOffset) {}
+
+  ~TypedMsgQueue() {}
+
+  void Put(T* msg) { PutLink(&(msg->*Link)); }
+
+  T* Get() { return FromLink(GetLink(true)); }
+
+  T* TryGet() { return FromLink(GetLink(false)); }
+
+  using MsgQueue::SetBlock;
+  using MsgQueue::SetNonblock;
+  using MsgQueue::SetSpill;
+  using MsgQueue::EnableStats;
+  using MsgQueue::GetStats;
+
+ private:
+  static T* FromLink(void** link) {
+    return link ? reinterpret_cast<T*>(reinterpret_cast<char*>(link) - kLinkOffset) : nullptr;
+  }
+};
+
+#endif  // TYPED_MSGQUEUE_H_
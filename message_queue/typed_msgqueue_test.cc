@@ -0,0 +1,51 @@
+#include "typed_msgqueue.h"
+
+#include <cassert>
+#include <cstddef>
+#include <iostream>
+#include <thread>
+
+struct Msg {
+  char m0;
+  short m1;
+  int m2;
+  double m3;
+  void* link;
+  char m4[64];
+};
+
+static_assert(typed_msgqueue_internal::LinkOffset<Msg, &Msg::link>::kValue == offsetof(Msg, link),
+              "link offset is a compile-time constant");
+
+int main() {
+  TypedMsgQueue<Msg, &Msg::link> mq(10);
+
+  Msg msg_in1{'A', 2022, 1000000, 3.14, nullptr, "hello, world"};
+  mq.Put(&msg_in1);
+  Msg* msg_out1 = mq.Get();
+  assert(msg_out1 == &msg_in1);
+  assert(msg_out1->m2 == 1000000);
+
+  const size_t kMsgs = 100000;
+  std::thread producer([&mq, kMsgs] {
+    for (size_t i = 0; i < kMsgs; ++i) {
+      auto msg = new Msg;
+      msg->m2 = static_cast<int>(i);
+      mq.Put(msg);
+    }
+  });
+
+  for (size_t i = 0; i < kMsgs; ++i) {
+    Msg* msg = mq.Get();
+    assert(msg && msg->m2 == static_cast<int>(i));
+    delete msg;
+  }
+  producer.join();
+
+  assert(mq.TryGet() == nullptr);
+  mq.SetNonblock();
+  assert(mq.Get() == nullptr);
+
+  std::cout << "OK" << std::endl;
+  return 0;
+}
@@ -0,0 +1,127 @@
+#ifndef ATOMIC_SHARED_PTR_H_
+#define ATOMIC_SHARED_PTR_H_
+
+#include <cassert>
+#include <cstdint>
+#include <utility>
+
+#include "dwcas.h"
+#include "shared_ptr.h"
+
+// A SharedPtr slot that threads may read and replace concurrently without a lock, e.g. to publish
+// immutable snapshots:
+//   AtomicSharedPtr<RoutingTable> table;
+//   table.Store(MakeShared<RoutingTable, AtomicCount>(...));         // writer
+//   SharedPtr<RoutingTable, AtomicCount> snapshot = table.Load();   // readers
+//
+// Split reference counts. The slot is one 128-bit word: the object pointer, and the control block
+// pointer with a 16-bit local count in its top bits. The slot owns one reference in the block's
+// shared_count. Load() cannot simply increment shared_count, because the block may be freed
+// between reading the slot and the increment. Instead it first borrows from the slot by bumping
+// the local count with a DWCAS on the whole word, which also proves the block is still installed.
+// Then it takes its own reference in shared_count and returns the borrow. Whoever replaces the
+// block in the slot moves the outstanding borrows into shared_count at the same time. A reader
+// that finds its block replaced therefore returns its borrow to shared_count instead.
+//
+// If the same block is replaced and later installed again, a reader may return its borrow to the
+// newer installation's local count. The count then goes negative, but it is signed, and the
+// shared_count it will be added to already holds that borrow, so the totals still agree.
+//
+// The block pointer must fit in 48 bits, as for TaggedPtr, and at most 32767 Load() calls may be
+// in progress on one slot at a time.
+template <typename T>
+class AtomicSharedPtr {
+ public:
+  using Ptr = SharedPtr<T, AtomicCount>;
+
+  AtomicSharedPtr() noexcept = default;
+
+  explicit AtomicSharedPtr(Ptr desired) noexcept : word_(Pack(desired)) {}
+
+  AtomicSharedPtr(const AtomicSharedPtr& other) = delete;
+
+  AtomicSharedPtr& operator=(const AtomicSharedPtr& other) = delete;
+
+  ~AtomicSharedPtr() { Unpack(word_); }
+
+  Ptr Load() noexcept {
+    DwcasPair word = DwcasLoad(&word_);
+    do {
+      if (!Count(word)) return Ptr();
+    } while (!Dwcas(&word_, &word, {word.lo, word.hi + kLocalOne}));
+
+    T* data = Data(word);
+    SharedCount<AtomicCount>* count = Count(word);
+    count->shared_count.Increment();
+
+    word.hi += kLocalOne;
+    while (Count(word) == count) {
+      if (Dwcas(&word_, &word, {word.lo, word.hi - kLocalOne})) return Ptr(count, data);
+    }
+    // replaced meanwhile, and the borrow went into shared_count; we hold a reference as well, so
+    // this never destroys the object
+    count->Release();
+    return Ptr(count, data);
+  }
+
+  void Store(Ptr desired) noexcept { Exchange(std::move(desired)); }
+
+  Ptr Exchange(Ptr desired) noexcept {
+    DwcasPair next = Pack(desired);
+    DwcasPair word = DwcasLoad(&word_);
+    while (!Dwcas(&word_, &word, next)) {
+    }
+    return Unpack(word);
+  }
+
+  // Replaces the stored pointer with desired if it shares expected's object and control block.
+  // Otherwise loads it into expected.
+  bool CompareExchange(Ptr& expected, Ptr desired) noexcept {
+    DwcasPair next = Pack(desired);
+    DwcasPair word = DwcasLoad(&word_);
+    while (Data(word) == expected.data_ && Count(word) == expected.count_) {
+      // a failure here may be only the local count moving
+      if (Dwcas(&word_, &word, next)) {
+        Unpack(word);
+        return true;
+      }
+    }
+    Unpack(next);
+    expected = Load();
+    return false;
+  }
+
+ private:
+  static constexpr uint64_t kLocalOne = static_cast<uint64_t>(1) << 48;
+  static constexpr uint64_t kCountMask = kLocalOne - 1;
+
+  static T* Data(DwcasPair word) noexcept { return reinterpret_cast<T*>(word.lo); }
+
+  static SharedCount<AtomicCount>* Count(DwcasPair word) noexcept {
+    return reinterpret_cast<SharedCount<AtomicCount>*>(word.hi & kCountMask);
+  }
+
+  // takes over ptr's reference
+  static DwcasPair Pack(Ptr& ptr) noexcept {
+    DwcasPair word = {reinterpret_cast<uint64_t>(ptr.data_),
+                      reinterpret_cast<uint64_t>(ptr.count_)};
+    assert((word.hi & ~kCountMask) == 0);
+    ptr.data_ = nullptr;
+    ptr.count_ = nullptr;
+    return word;
+  }
+
+  // Turns a word taken out of the slot back into a SharedPtr owning the slot's reference, moving
+  // the borrows into shared_count.
+  static Ptr Unpack(DwcasPair word) noexcept {
+    SharedCount<AtomicCount>* count = Count(word);
+    if (!count) return Ptr();
+    int16_t local = static_cast<int16_t>(word.hi >> 48);
+    if (local != 0) count->shared_count.Add(static_cast<size_t>(static_cast<int64_t>(local)));
+    return Ptr(count, Data(word));
+  }
+
+  DwcasPair word_ = {0, 0};
+};
+
+#endif  // ATOMIC_SHARED_PTR_H_
@@ -0,0 +1,96 @@
+// Snapshot reads per second with one writer publishing a new snapshot about every 10us, as the
+// number of readers grows: AtomicSharedPtr against a SharedPtr guarded by a pthread_mutex.
+//   g++ -std=c++17 -O2 -pthread -I../lockfree -I../atomic atomic_shared_ptr_bench.cc
+//       -o atomic_shared_ptr_bench
+//   ./atomic_shared_ptr_bench [milliseconds per run]
+
+#include <pthread.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "atomic.h"
+#include "atomic_shared_ptr.h"
+
+struct Table {
+  explicit Table(uint64_t version) : version(version) {}
+  uint64_t version;
+  uint64_t routes[64] = {};
+};
+
+using Ptr = SharedPtr<Table, AtomicCount>;
+
+class MutexSharedPtr {
+ public:
+  Ptr Load() {
+    pthread_mutex_lock(&mutex_);
+    Ptr ptr = ptr_;
+    pthread_mutex_unlock(&mutex_);
+    return ptr;
+  }
+
+  void Store(Ptr desired) {
+    pthread_mutex_lock(&mutex_);
+    ptr_.swap(desired);
+    pthread_mutex_unlock(&mutex_);
+  }
+
+ private:
+  pthread_mutex_t mutex_ = PTHREAD_MUTEX_INITIALIZER;
+  Ptr ptr_;
+};
+
+template <typename Slot>
+void Run(const char* name, size_t nreaders, int millis) {
+  Slot slot;
+  slot.Store(MakeShared<Table, AtomicCount>(0));
+  Atomic<bool> done(false);
+  std::vector<uint64_t> reads(nreaders, 0);
+
+  std::vector<std::thread> readers;
+  for (size_t i = 0; i < nreaders; ++i) {
+    readers.emplace_back([&slot, &done, &reads, i] {
+      uint64_t n = 0, sink = 0;
+      while (!done.Load(MemoryOrder::kRelaxed)) {
+        Ptr table = slot.Load();
+        sink += table->version + table->routes[n % 64];
+        ++n;
+      }
+      asm volatile("" : : "r"(sink));
+      reads[i] = n;
+    });
+  }
+
+  std::thread writer([&slot, &done] {
+    for (uint64_t version = 1; !done.Load(MemoryOrder::kRelaxed); ++version) {
+      slot.Store(MakeShared<Table, AtomicCount>(version));
+      std::this_thread::sleep_for(std::chrono::microseconds(10));
+    }
+  });
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(millis));
+  done.Store(true);
+  for (auto& t : readers) t.join();
+  writer.join();
+
+  uint64_t total = 0;
+  for (uint64_t n : reads) total += n;
+  printf("%-8s %8zu %14.2f\n", name, nreaders, total / (millis * 1e3));
+}
+
+int main(int argc, char* argv[]) {
+  int millis = argc > 1 ? atoi(argv[1]) : 1000;
+  size_t ncpus = std::thread::hardware_concurrency();
+
+  printf("%-8s %8s %14s\n", "slot", "readers", "Mreads/s");
+  for (size_t nreaders = 1; nreaders <= ncpus; nreaders *= 2) {
+    Run<AtomicSharedPtr<Table>>("atomic", nreaders, millis);
+    Run<MutexSharedPtr>("mutex", nreaders, millis);
+  }
+
+  return 0;
+}
@@ -0,0 +1,105 @@
+#include "atomic_shared_ptr.h"
+
+#include <thread>
+#include <vector>
+
+struct Snapshot {
+  explicit Snapshot(uint64_t version) : version(version), check(~version) {
+    __atomic_fetch_add(&live, 1, __ATOMIC_RELAXED);
+  }
+  ~Snapshot() {
+    check = 0;
+    __atomic_fetch_sub(&live, 1, __ATOMIC_RELAXED);
+  }
+  uint64_t version;
+  uint64_t check;
+  static int live;
+};
+
+int Snapshot::live = 0;
+
+using Ptr = SharedPtr<Snapshot, AtomicCount>;
+
+void TestAtomicSharedPtr() {
+  {
+    AtomicSharedPtr<Snapshot> slot;
+    assert(!slot.Load());
+
+    Ptr first = MakeShared<Snapshot, AtomicCount>(1);
+    slot.Store(first);
+    Ptr loaded = slot.Load();
+    assert(loaded.Get() == first.Get());
+
+    Ptr old = slot.Exchange(MakeShared<Snapshot, AtomicCount>(2));
+    assert(old.Get() == first.Get());
+    assert(slot.Load()->version == 2);
+
+    // expected is stale: fails and gets the current pointer
+    Ptr expected = first;
+    assert(!slot.CompareExchange(expected, MakeShared<Snapshot, AtomicCount>(3)));
+    assert(expected->version == 2);
+    assert(slot.CompareExchange(expected, MakeShared<Snapshot, AtomicCount>(3)));
+    assert(slot.Load()->version == 3);
+
+    // a block installed again after being replaced
+    Ptr again = slot.Load();
+    slot.Store(first);
+    slot.Store(again);
+    slot.Store(again);
+    assert(slot.Load().Get() == again.Get());
+
+    slot.Store(Ptr());
+    assert(!slot.Load());
+  }
+  assert(Snapshot::live == 0);
+
+  {
+    AtomicSharedPtr<Snapshot> slot(MakeShared<Snapshot, AtomicCount>(1));
+    assert(slot.Load()->version == 1);
+  }
+  assert(Snapshot::live == 0);
+}
+
+// Readers keep loading while a writer publishes new snapshots and sometimes puts an old one back.
+// Every snapshot a reader gets must be intact, and every snapshot must be destroyed in the end.
+void TestConcurrent() {
+  const int kReaders = 4;
+  const uint64_t kVersions = 20000;
+
+  {
+    AtomicSharedPtr<Snapshot> slot(MakeShared<Snapshot, AtomicCount>(0));
+    bool done = false;
+
+    std::vector<std::thread> readers;
+    for (int i = 0; i < kReaders; ++i) {
+      readers.emplace_back([&slot, &done] {
+        while (!__atomic_load_n(&done, __ATOMIC_ACQUIRE)) {
+          Ptr snapshot = slot.Load();
+          assert(snapshot);
+          assert(snapshot->check == ~snapshot->version);
+          std::this_thread::yield();
+        }
+      });
+    }
+
+    Ptr kept = slot.Load();
+    for (uint64_t version = 1; version <= kVersions; ++version) {
+      if (version % 16 == 0) {
+        slot.Store(kept);
+      } else {
+        Ptr expected = slot.Load();
+        bool ok = slot.CompareExchange(expected, MakeShared<Snapshot, AtomicCount>(version));
+        assert(ok);
+      }
+    }
+    __atomic_store_n(&done, true, __ATOMIC_RELEASE);
+    for (auto& t : readers) t.join();
+  }
+  assert(Snapshot::live == 0);
+}
+
+int main() {
+  TestAtomicSharedPtr();
+  TestConcurrent();
+  return 0;
+}
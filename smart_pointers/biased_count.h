@@ -0,0 +1,294 @@
+#ifndef BIASED_COUNT_H_
+#define BIASED_COUNT_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "shared_count.h"
+
+// Biased reference counting (Choi, Shull and Torrellas, PACT 2018), for objects that are mostly
+// copied on the thread that created them:
+//   SharedPtr<Foo, BiasedCount> sp(new Foo);
+// The creating thread, the owner, counts in a plain integer, biased_. Other threads count in an
+// atomic word, shared_, so the owner's copies cost what NonAtomicCount's do. The number of
+// references is biased_ plus the count in shared_.
+//
+// shared_ may go negative: a copy made by the owner and dropped elsewhere increments biased_ and
+// decrements shared_. The thread that makes it negative flags the block as queued and hands it to
+// the owner. The owner merges queued blocks the next time it drops a reference, or when it calls
+// BiasedCount::Drain(). Merging moves biased_ into shared_ and marks the block merged, after which
+// everyone counts in shared_. The owner also merges when biased_ drops to zero. The object is
+// destroyed once it is merged and the count in shared_ reaches zero. So an object released by
+// another thread lives until its owner next gets around to merging. A thread that is idle for long
+// should call Drain().
+//
+// The owner record stays alive while any block it owns is unmerged. Once a block is queued,
+// that reference belongs to the queue entry, so the owner may merge the block in the meantime
+// and the queueing thread can still enqueue it.
+//
+// When the owner thread exits, it merges its queue, and blocks queued later are merged right away
+// by the thread queueing them. WeakPtr::Lock() from another thread succeeds until the block has
+// been merged, even if the last reference is already gone and the block is only waiting to be
+// merged. The object is still alive then, and the merge accounts for the new reference.
+//
+// weak_count is an AtomicCount.
+
+class BiasedCount;
+
+namespace biased_internal {
+
+// Per-thread record of the blocks it owns that other threads have queued for merging. It is
+// freed once its thread has exited and every block it owned is merged.
+class Owner {
+ public:
+  // the calling thread's record, created on first use
+  static Owner* Get() {
+    if (!current) {
+      current = new Owner;
+      static thread_local ExitHook exit_hook;
+      (void)exit_hook;
+    }
+    return current;
+  }
+
+  void Ref() noexcept { __atomic_fetch_add(&refs_, 1, __ATOMIC_RELAXED); }
+
+  void Unref() noexcept {
+    if (__atomic_sub_fetch(&refs_, 1, __ATOMIC_ACQ_REL) == 0) delete this;
+  }
+
+  void Enqueue(SharedCount<BiasedCount>* block);
+
+  bool Pending() const noexcept { return __atomic_load_n(&pending_, __ATOMIC_RELAXED); }
+
+  void Drain();
+
+  // the calling thread's record, nullptr if it hasn't created one or has exited
+  static inline thread_local Owner* current = nullptr;
+
+ private:
+  struct ExitHook {
+    ~ExitHook() { current->Exit(); }
+  };
+
+  Owner() = default;
+
+  void Exit();
+
+  std::mutex mutex_;
+  std::vector<SharedCount<BiasedCount>*> queue_;
+  bool pending_ = false;
+  bool exited_ = false;
+  // one for the thread while it runs, one per block that is unmerged or queued
+  size_t refs_ = 1;
+};
+
+}  // namespace biased_internal
+
+class BiasedCount {
+ public:
+  explicit BiasedCount(size_t count) noexcept;
+
+  BiasedCount(const BiasedCount& other) = delete;
+
+  BiasedCount& operator=(const BiasedCount& other) = delete;
+
+  void Increment() noexcept {
+    if (IsOwner())
+      ++biased_;
+    else
+      __atomic_fetch_add(&shared_, kOne, __ATOMIC_RELAXED);
+  }
+
+  // the owner's common case inline, everything else out of line
+  bool Decrement() noexcept {
+    if (IsOwner() && !biased_internal::Owner::current->Pending()) {
+      return --biased_ == 0 && Merge() == 0;
+    }
+    return DecrementSlow();
+  }
+
+  bool IncrementIfNonzero() noexcept;
+
+  // 0 once the object is gone. Another thread cannot read biased_ and returns at least 1 until
+  // the block is merged.
+  size_t Load() const noexcept;
+
+  // Merges the blocks that other threads have queued for the calling thread.
+  static void Drain() {
+    if (biased_internal::Owner::current) biased_internal::Owner::current->Drain();
+  }
+
+ private:
+  friend struct CountTraits<BiasedCount>;
+  friend class biased_internal::Owner;
+
+  // shared_: the count in units of kOne, plus two flags
+  static constexpr int64_t kMerged = 1;
+  static constexpr int64_t kQueued = 2;
+  static constexpr int64_t kOne = 4;
+
+  // an arithmetic shift, since division would round a negative count with flags toward zero
+  static int64_t Value(int64_t shared) noexcept { return shared >> 2; }
+
+  bool IsOwner() const noexcept {
+    biased_internal::Owner* owner = __atomic_load_n(&owner_, __ATOMIC_RELAXED);
+    return owner && owner == biased_internal::Owner::current;
+  }
+
+  bool DecrementSlow() noexcept;
+
+  // Moves biased_ into shared_, on the owner thread or after it has exited. Returns the count.
+  int64_t Merge() noexcept;
+
+  // Merges a block taken from owner's queue, unless the owner has merged it already, and drops
+  // the weak and the owner references the queue held.
+  static void MergeQueued(biased_internal::Owner* owner,
+                          SharedCount<BiasedCount>* block) noexcept;
+
+  // nullptr once merged
+  biased_internal::Owner* owner_;
+  // the owner, even after the merge
+  biased_internal::Owner* const record_;
+  SharedCount<BiasedCount>* block_ = nullptr;
+  int64_t biased_;
+  int64_t shared_ = 0;
+};
+
+template <>
+struct CountTraits<BiasedCount> {
+  using Weak = AtomicCount;
+
+  static void Attach(BiasedCount* count, SharedCount<BiasedCount>* block) noexcept {
+    count->block_ = block;
+  }
+};
+
+inline BiasedCount::BiasedCount(size_t count) noexcept
+    : owner_(biased_internal::Owner::Get()),
+      record_(owner_),
+      biased_(static_cast<int64_t>(count)) {
+  record_->Ref();
+}
+
+inline int64_t BiasedCount::Merge() noexcept {
+  int64_t biased = biased_;
+  biased_ = 0;
+  __atomic_store_n(&owner_, nullptr, __ATOMIC_RELAXED);
+  int64_t old = __atomic_fetch_add(&shared_, biased * kOne + kMerged, __ATOMIC_ACQ_REL);
+  // once queued, the queue entry holds the block's reference to the owner
+  if (!(old & kQueued)) record_->Unref();
+  return Value(old) + biased;
+}
+
+inline void BiasedCount::MergeQueued(biased_internal::Owner* owner,
+                                     SharedCount<BiasedCount>* block) noexcept {
+  BiasedCount& count = block->shared_count;
+  // the owner may have merged on its own since
+  if (__atomic_load_n(&count.owner_, __ATOMIC_RELAXED) && count.Merge() == 0) block->Expire();
+  block->WeakRelease();
+  owner->Unref();
+}
+
+__attribute__((noinline)) inline bool BiasedCount::DecrementSlow() noexcept {
+  if (IsOwner()) {
+    biased_internal::Owner::current->Drain();
+    // the drain may have merged this very block
+    if (IsOwner()) return --biased_ == 0 && Merge() == 0;
+  }
+
+  // While the queue holds the block, it also holds a weak reference, taken before the CAS that
+  // flags the block while ours still keeps it alive.
+  bool pinned = false;
+  int64_t old = __atomic_load_n(&shared_, __ATOMIC_RELAXED);
+  int64_t next;
+  do {
+    next = old - kOne;
+    if (!(old & (kMerged | kQueued)) && Value(next) < 0) {
+      next |= kQueued;
+      if (!pinned) {
+        block_->weak_count.Increment();
+        pinned = true;
+      }
+    }
+  } while (!__atomic_compare_exchange_n(&shared_, &old, next, true, __ATOMIC_ACQ_REL,
+                                        __ATOMIC_RELAXED));
+
+  if ((next & kQueued) && !(old & kQueued)) {
+    // The CAS saw the block unmerged, so the owner's reference now belongs to the queue entry
+    // and keeps record_ alive, even if the owner merges the block before it is enqueued.
+    record_->Enqueue(block_);
+    return false;
+  }
+  if (pinned) block_->WeakRelease();
+  return (next & kMerged) && Value(next) == 0;
+}
+
+inline bool BiasedCount::IncrementIfNonzero() noexcept {
+  if (IsOwner()) {
+    if (biased_ + Value(__atomic_load_n(&shared_, __ATOMIC_RELAXED)) <= 0) return false;
+    ++biased_;
+    return true;
+  }
+
+  int64_t old = __atomic_load_n(&shared_, __ATOMIC_RELAXED);
+  do {
+    if ((old & kMerged) && Value(old) == 0) return false;
+  } while (!__atomic_compare_exchange_n(&shared_, &old, old + kOne, true, __ATOMIC_RELAXED,
+                                        __ATOMIC_RELAXED));
+  return true;
+}
+
+inline size_t BiasedCount::Load() const noexcept {
+  int64_t shared = __atomic_load_n(&shared_, __ATOMIC_ACQUIRE);
+  int64_t count;
+  if (IsOwner())
+    count = biased_ + Value(shared);
+  else if (shared & kMerged)
+    count = Value(shared);
+  else
+    count = Value(shared) > 0 ? Value(shared) : 1;
+  return count > 0 ? static_cast<size_t>(count) : 0;
+}
+
+namespace biased_internal {
+
+inline void Owner::Enqueue(SharedCount<BiasedCount>* block) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (exited_) {
+    // nobody else will merge it, and the mutex orders this after the owner's last update
+    lock.unlock();
+    BiasedCount::MergeQueued(this, block);
+    return;
+  }
+  queue_.push_back(block);
+  __atomic_store_n(&pending_, true, __ATOMIC_RELAXED);
+}
+
+inline void Owner::Drain() {
+  std::vector<SharedCount<BiasedCount>*> queue;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    queue.swap(queue_);
+    __atomic_store_n(&pending_, false, __ATOMIC_RELAXED);
+  }
+  for (SharedCount<BiasedCount>* block : queue) BiasedCount::MergeQueued(this, block);
+}
+
+inline void Owner::Exit() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    exited_ = true;
+  }
+  // nothing can be added now
+  for (SharedCount<BiasedCount>* block : queue_) BiasedCount::MergeQueued(this, block);
+  queue_.clear();
+  current = nullptr;
+  Unref();
+}
+
+}  // namespace biased_internal
+
+#endif  // BIASED_COUNT_H_
@@ -0,0 +1,52 @@
+// Cost of copying and dropping a SharedPtr under each count policy: on the thread that created
+// the object, and on another thread, where BiasedCount pays for an atomic like AtomicCount.
+//   g++ -std=c++17 -O2 -pthread biased_count_bench.cc -o biased_count_bench
+//   ./biased_count_bench [copies]
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+#include "biased_count.h"
+#include "shared_ptr.h"
+
+struct Payload {
+  uint64_t value = 1;
+};
+
+template <typename Count>
+double CopyDrop(const SharedPtr<Payload, Count>& sp, uint64_t n) {
+  uint64_t sink = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (uint64_t i = 0; i < n; ++i) {
+    SharedPtr<Payload, Count> copy(sp);
+    asm volatile("" : : "r"(copy.Get()) : "memory");
+    sink += copy->value;
+  }
+  double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start)
+                  .count();
+  asm volatile("" : : "r"(sink));
+  return ns / n;
+}
+
+template <typename Count>
+void Run(const char* name, uint64_t n) {
+  SharedPtr<Payload, Count> sp(new Payload);
+  double owner_ns = CopyDrop(sp, n);
+  double other_ns = 0;
+  std::thread([&sp, &other_ns, n] { other_ns = CopyDrop(sp, n); }).join();
+  printf("%-16s %12.2f %12.2f\n", name, owner_ns, other_ns);
+}
+
+int main(int argc, char* argv[]) {
+  uint64_t n = argc > 1 ? strtoull(argv[1], nullptr, 10) : 10000000;
+
+  printf("%-16s %12s %12s\n", "count", "owner ns", "other ns");
+  Run<NonAtomicCount>("NonAtomicCount", n);
+  Run<AtomicCount>("AtomicCount", n);
+  Run<BiasedCount>("BiasedCount", n);
+
+  return 0;
+}
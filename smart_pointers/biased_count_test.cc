@@ -0,0 +1,172 @@
+#include "biased_count.h"
+
+#include <cassert>
+#include <thread>
+#include <vector>
+
+#include "shared_ptr.h"
+#include "weak_ptr.h"
+
+struct Counted {
+  explicit Counted(int* destroyed) : destroyed(destroyed) {}
+  ~Counted() { __atomic_fetch_add(destroyed, 1, __ATOMIC_RELAXED); }
+  int* destroyed;
+};
+
+using Ptr = SharedPtr<Counted, BiasedCount>;
+
+static int Destroyed(int* destroyed) { return __atomic_load_n(destroyed, __ATOMIC_RELAXED); }
+
+void TestOwner() {
+  int destroyed = 0;
+  {
+    Ptr sp1(new Counted(&destroyed));
+    Ptr sp2(sp1);
+    Ptr sp3 = sp2;
+    WeakPtr<Counted, BiasedCount> wp(sp1);
+    assert(wp.Lock());
+    sp1.Reset();
+    sp2.Reset();
+    assert(!wp.Expired());
+    sp3.Reset();
+    assert(Destroyed(&destroyed) == 1);
+    assert(wp.Expired());
+    assert(!wp.Lock());
+  }
+
+  {
+    Ptr sp = MakeShared<Counted, BiasedCount>(&destroyed);
+  }
+  assert(Destroyed(&destroyed) == 2);
+}
+
+// Copies made by the owner and dropped elsewhere send the count negative; the object goes when
+// the owner merges.
+void TestQueued() {
+  int destroyed = 0;
+  Ptr sp1(new Counted(&destroyed));
+  Ptr sp2(sp1);
+  std::thread([&sp1, &sp2] {
+    sp1.Reset();
+    sp2.Reset();
+  }).join();
+  // no references left, but biased_ still holds two until the owner merges
+  assert(Destroyed(&destroyed) == 0);
+  BiasedCount::Drain();
+  assert(Destroyed(&destroyed) == 1);
+
+  // or the next time the owner drops a reference to anything
+  Ptr sp3(new Counted(&destroyed));
+  Ptr other(new Counted(&destroyed));
+  std::thread([&sp3] { sp3.Reset(); }).join();
+  assert(Destroyed(&destroyed) == 1);
+  other.Reset();
+  assert(Destroyed(&destroyed) == 3);
+}
+
+// Other threads copy and drop while the owner does too, and then the owner goes first.
+void TestConcurrent() {
+  const int kThreads = 4;
+  const int kCopies = 100000;
+
+  int destroyed = 0;
+  Ptr sp(new Counted(&destroyed));
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kThreads; ++i) {
+    threads.emplace_back([copy = sp, kCopies]() mutable {
+      WeakPtr<Counted, BiasedCount> wp(copy);
+      for (int j = 0; j < kCopies; ++j) {
+        Ptr tmp(copy);
+        Ptr locked = wp.Lock();
+        assert(locked.Get() == copy.Get());
+      }
+      copy.Reset();
+    });
+  }
+  for (int j = 0; j < kCopies; ++j) Ptr tmp(sp);
+  sp.Reset();
+  for (auto& t : threads) t.join();
+  BiasedCount::Drain();
+  assert(Destroyed(&destroyed) == 1);
+}
+
+// Blocks of an exited owner are merged by whoever drops the last reference.
+void TestOwnerExit() {
+  int destroyed = 0;
+  Ptr sp;
+  std::thread([&sp, &destroyed] {
+    Ptr owned(new Counted(&destroyed));
+    sp = owned;
+  }).join();
+  Ptr sp2(sp);
+  assert(Destroyed(&destroyed) == 0);
+  sp.Reset();
+  sp2.Reset();
+  assert(Destroyed(&destroyed) == 1);
+
+  // queued before the owner exits
+  Ptr sp3;
+  std::thread([&sp3, &destroyed] {
+    Ptr owned(new Counted(&destroyed));
+    Ptr copy(owned);
+    std::thread([&copy] { copy.Reset(); }).join();
+    sp3 = std::move(owned);
+  }).join();
+  assert(Destroyed(&destroyed) == 1);
+  sp3.Reset();
+  assert(Destroyed(&destroyed) == 2);
+}
+
+// One thread queues the block, sending the count negative. Meanwhile another locks a
+// reference, which brings the count back to zero, and hands it to the owner. The owner drops
+// it, merges the block and exits, possibly before the block reaches its queue.
+void TestQueueWhileMerging() {
+  const int kRounds = 1000;
+
+  for (int round = 0; round < kRounds; ++round) {
+    int destroyed = 0;
+    Ptr copy;
+    WeakPtr<Counted, BiasedCount> weak;
+    Ptr locked;
+    int stage = 0;
+    auto wait = [&stage](int at_least) {
+      while (__atomic_load_n(&stage, __ATOMIC_ACQUIRE) < at_least) std::this_thread::yield();
+    };
+    auto advance = [&stage](int to) { __atomic_store_n(&stage, to, __ATOMIC_RELEASE); };
+
+    std::thread owner([&] {
+      Ptr owned(new Counted(&destroyed));
+      copy = owned;
+      weak = owned;
+      advance(1);
+      wait(3);
+      owned.Reset();
+      locked.Reset();
+    });
+    std::thread queuer([&] {
+      wait(1);
+      advance(2);
+      copy.Reset();
+    });
+    std::thread locker([&] {
+      wait(2);
+      for (int i = 0; i < round % 4; ++i) std::this_thread::yield();
+      locked = weak.Lock();
+      assert(locked);
+      advance(3);
+    });
+    owner.join();
+    queuer.join();
+    locker.join();
+    assert(Destroyed(&destroyed) == 1);
+  }
+}
+
+int main() {
+  TestOwner();
+  TestQueued();
+  TestConcurrent();
+  TestOwnerExit();
+  TestQueueWhileMerging();
+  return 0;
+}
@@ -0,0 +1,30 @@
+#ifndef COUNT_NEW_H_
+#define COUNT_NEW_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+// Replaces the global operator new and delete with versions that count calls to operator new,
+// for the tests and benchmarks that check how often a pointer allocates:
+//   uint64_t before = Allocations();
+// Replacement functions can't be inline, so include this in one translation unit per program.
+
+static uint64_t allocations = 0;
+
+inline uint64_t Allocations() { return __atomic_load_n(&allocations, __ATOMIC_RELAXED); }
+
+// All out of line: once inlined, GCC pairs malloc() with operator delete, or operator new with
+// free(), and warns about the mismatch.
+__attribute__((noinline)) void* operator new(size_t size) {
+  __atomic_fetch_add(&allocations, 1, __ATOMIC_RELAXED);
+  if (void* p = malloc(size)) return p;
+  throw std::bad_alloc();
+}
+
+__attribute__((noinline)) void operator delete(void* p) noexcept { free(p); }
+
+__attribute__((noinline)) void operator delete(void* p, size_t) noexcept { free(p); }
+
+#endif  // COUNT_NEW_H_
@@ -0,0 +1,127 @@
+#ifndef DEFERRED_DELETE_H_
+#define DEFERRED_DELETE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <thread>
+
+#include "typed_msgqueue.h"
+
+// Deleter that moves the destructor off the releasing thread:
+//   SharedPtr<Table> table(new Table, DeferredDelete<Table>());
+// When the last reference is dropped, the object is appended to a batch kept per thread, and full
+// batches of 64 go over a MsgQueue to a background thread that runs the destructors. So the hot
+// thread does O(1) work per release, plus one queue put per batch. Only the control block is
+// still freed inline, and the object too if no batch can be allocated for it.
+//
+// Objects wait in a partial batch until it fills, the thread calls
+// DeferredReclaimer::Instance().Flush(), or the thread exits. Destructors run in retirement order
+// per thread, with no ordering between threads. The reclaimer drains the queue on process exit,
+// from an atexit() handler. It is never destroyed itself, so threads and static destructors that
+// release objects after that are still safe, but those objects are not destroyed.
+
+class DeferredReclaimer {
+ public:
+  static constexpr size_t kBatchSize = 64;
+
+  static DeferredReclaimer& Instance() {
+    static DeferredReclaimer* reclaimer = new DeferredReclaimer;
+    return *reclaimer;
+  }
+
+  DeferredReclaimer(const DeferredReclaimer& other) = delete;
+
+  DeferredReclaimer& operator=(const DeferredReclaimer& other) = delete;
+
+  // destroy(p) will be called on the reclaimer thread, or right here if out of memory
+  void Retire(void* p, void (*destroy)(void*)) noexcept {
+    Batch*& batch = Local();
+    if (!batch) {
+      batch = new (std::nothrow) Batch;
+      if (!batch) {
+        destroy(p);
+        return;
+      }
+    }
+    batch->items[batch->count++] = {p, destroy};
+    if (batch->count == kBatchSize) {
+      queue_.Put(batch);
+      batch = nullptr;
+    }
+  }
+
+  // Sends this thread's partial batch now.
+  void Flush() {
+    Batch*& batch = Local();
+    if (batch) {
+      queue_.Put(batch);
+      batch = nullptr;
+    }
+  }
+
+  // objects destroyed so far
+  uint64_t Reclaimed() const { return __atomic_load_n(&reclaimed_, __ATOMIC_RELAXED); }
+
+ private:
+  struct Item {
+    void* p;
+    void (*destroy)(void*);
+  };
+
+  struct Batch {
+    void* link;
+    size_t count = 0;
+    Item items[kBatchSize];
+  };
+
+  // flushes the thread's batch at thread exit
+  struct LocalFlush {
+    ~LocalFlush() { Instance().Flush(); }
+  };
+
+  // Never blocks a producer, the queue grows instead.
+  DeferredReclaimer() : queue_(SIZE_MAX), thread_([this] { Run(); }) { atexit(Drain); }
+
+  // The reclaimer thread destroys what is queued and exits; later batches stay in the queue.
+  static void Drain() {
+    DeferredReclaimer& reclaimer = Instance();
+    reclaimer.queue_.SetNonblock();
+    reclaimer.thread_.join();
+  }
+
+  // The batch pointer is trivially destructible, so a release later in thread exit, e.g. from a
+  // static destructor on the main thread, still finds it; that batch is never sent.
+  static Batch*& Local() {
+    static thread_local Batch* batch = nullptr;
+    static thread_local LocalFlush flush;
+    return batch;
+  }
+
+  void Run() {
+    while (Batch* batch = queue_.Get()) {
+      for (size_t i = 0; i < batch->count; ++i) batch->items[i].destroy(batch->items[i].p);
+      __atomic_fetch_add(&reclaimed_, batch->count, __ATOMIC_RELAXED);
+      delete batch;
+      // destructors that dropped further DeferredDelete objects
+      Flush();
+    }
+  }
+
+  TypedMsgQueue<Batch, &Batch::link> queue_;
+  uint64_t reclaimed_ = 0;
+  std::thread thread_;
+};
+
+template <typename T>
+struct DeferredDelete {
+  // starts the reclaimer here, where a failure can still throw, rather than on release
+  DeferredDelete() { DeferredReclaimer::Instance(); }
+
+  void operator()(T* data) const noexcept {
+    DeferredReclaimer::Instance().Retire(data, [](void* p) { delete static_cast<T*>(p); });
+  }
+};
+
+#endif  // DEFERRED_DELETE_H_
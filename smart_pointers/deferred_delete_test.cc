@@ -0,0 +1,113 @@
+#include "deferred_delete.h"
+
+#include <cassert>
+#include <chrono>
+#include <new>
+#include <thread>
+#include <vector>
+
+#include "shared_ptr.h"
+
+struct Big {
+  ~Big() {
+    assert(std::this_thread::get_id() != owner);
+    __atomic_fetch_add(&destroyed, 1, __ATOMIC_RELAXED);
+  }
+  std::thread::id owner = std::this_thread::get_id();
+  std::vector<int> data = std::vector<int>(1000);
+  // a child retired by the reclaimer while it destroys this one
+  SharedPtr<Big> child;
+  static int destroyed;
+};
+
+int Big::destroyed = 0;
+
+static void WaitReclaimed(uint64_t n) {
+  while (DeferredReclaimer::Instance().Reclaimed() < n) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+}
+
+void TestDeferredDelete() {
+  DeferredReclaimer& reclaimer = DeferredReclaimer::Instance();
+  uint64_t base = reclaimer.Reclaimed();
+
+  // a partial batch waits for Flush()
+  {
+    SharedPtr<Big> sp(new Big, DeferredDelete<Big>());
+    SharedPtr<Big> sp2(sp);
+  }
+  assert(__atomic_load_n(&Big::destroyed, __ATOMIC_RELAXED) == 0);
+  reclaimer.Flush();
+  WaitReclaimed(base + 1);
+  assert(__atomic_load_n(&Big::destroyed, __ATOMIC_RELAXED) == 1);
+
+  // full batches go without Flush()
+  {
+    std::vector<SharedPtr<Big>> sps;
+    for (size_t i = 0; i < DeferredReclaimer::kBatchSize; ++i) {
+      sps.emplace_back(new Big, DeferredDelete<Big>());
+    }
+  }
+  WaitReclaimed(base + 1 + DeferredReclaimer::kBatchSize);
+
+  // nested: the parent's destructor retires the child on the reclaimer thread
+  {
+    SharedPtr<Big> parent(new Big, DeferredDelete<Big>());
+    parent->child = SharedPtr<Big>(new Big, DeferredDelete<Big>());
+  }
+  reclaimer.Flush();
+  WaitReclaimed(base + 3 + DeferredReclaimer::kBatchSize);
+
+  // thread exit flushes
+  std::thread thread([] { SharedPtr<Big> sp(new Big, DeferredDelete<Big>()); });
+  thread.join();
+  WaitReclaimed(base + 4 + DeferredReclaimer::kBatchSize);
+  assert(__atomic_load_n(&Big::destroyed, __ATOMIC_RELAXED) ==
+         static_cast<int>(4 + DeferredReclaimer::kBatchSize));
+}
+
+// Retire() allocates its batches with the nothrow operator new, which fails on request here.
+static bool fail_nothrow_new = false;
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+  if (fail_nothrow_new) return nullptr;
+  try {
+    return ::operator new(size);
+  } catch (const std::bad_alloc&) {
+    return nullptr;
+  }
+}
+
+struct Small {
+  ~Small() { ++destroyed; }
+  static int destroyed;
+};
+
+int Small::destroyed = 0;
+
+// Without memory for a batch the object is destroyed inline instead of terminating.
+void TestOutOfMemory() {
+  DeferredReclaimer::Instance().Flush();
+  SharedPtr<Small> sp(new Small, DeferredDelete<Small>());
+  fail_nothrow_new = true;
+  sp.Reset();
+  fail_nothrow_new = false;
+  assert(Small::destroyed == 1);
+}
+
+// Constructed before the reclaimer, so destroyed after it has drained: the release must not touch
+// a destroyed reclaimer, the object is just left alone.
+struct LateRelease {
+  ~LateRelease() { sp = SharedPtr<Big>(); }
+  SharedPtr<Big> sp;
+} late_release;
+
+int main() {
+  late_release.sp = SharedPtr<Big>(new Big, DeferredDelete<Big>());
+  TestDeferredDelete();
+  TestOutOfMemory();
+  // left for the reclaimer to drain at exit
+  SharedPtr<Big> sp(new Big, DeferredDelete<Big>());
+  return 0;
+}
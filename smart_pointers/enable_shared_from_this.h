@@ -0,0 +1,44 @@
+#ifndef ENABLE_SHARED_FROM_THIS_H_
+#define ENABLE_SHARED_FROM_THIS_H_
+
+#include "shared_count.h"
+#include "shared_ptr.h"
+#include "weak_ptr.h"
+
+// Lets an object owned by SharedPtrs hand out more of them:
+//   class Session : public EnableSharedFromThis<Session> {
+//     void Start() { loop->Post([self = SharedFromThis()] { self->Read(); }); }
+//   };
+// The first SharedPtr to take ownership of the object, through SharedPtr(T*), Reset(T*),
+// MakeShared or AllocateShared, stores a WeakPtr to itself in the base. SharedFromThis() locks
+// it, so the result shares that control block and nothing is allocated.
+//
+// Count must match the SharedPtrs that own the object. SharedFromThis() is empty while no
+// SharedPtr owns the object, in the constructor and destructor in particular.
+template <typename T, typename Count = NonAtomicCount>
+class EnableSharedFromThis {
+  template <typename U, typename C>
+  friend class SharedPtr;
+
+ public:
+  SharedPtr<T, Count> SharedFromThis() { return weak_this_.Lock(); }
+
+  SharedPtr<const T, Count> SharedFromThis() const { return weak_this_.Lock(); }
+
+  WeakPtr<T, Count> WeakFromThis() const noexcept { return weak_this_; }
+
+ protected:
+  EnableSharedFromThis() noexcept = default;
+
+  // a copy is a different object, no SharedPtr owns it yet
+  EnableSharedFromThis(const EnableSharedFromThis&) noexcept {}
+
+  EnableSharedFromThis& operator=(const EnableSharedFromThis&) noexcept { return *this; }
+
+  ~EnableSharedFromThis() = default;
+
+ private:
+  mutable WeakPtr<T, Count> weak_this_;
+};
+
+#endif  // ENABLE_SHARED_FROM_THIS_H_
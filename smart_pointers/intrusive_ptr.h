@@ -0,0 +1,113 @@
+#ifndef INTRUSIVE_PTR_H_
+#define INTRUSIVE_PTR_H_
+
+#include <cassert>
+#include <utility>
+
+#include "shared_count.h"
+
+// Reference count embedded in the object, for pointers that are copied a lot:
+//   class Node : public RefCounted<Node, AtomicCount> { ... };
+//   IntrusivePtr<Node> p(new Node);
+//   IntrusivePtr<Node> q = p;
+// IntrusivePtr is one pointer wide and a copy touches only the object itself, with no separate
+// control block to allocate or miss on. Count is one of the policies from shared_count.h. There
+// is no weak reference.
+//
+// Release() deletes through Derived*, so classes deriving further from Derived need a virtual
+// destructor.
+template <typename Derived, typename Count = NonAtomicCount>
+class RefCounted {
+ public:
+  void AddRef() const noexcept { count_.Increment(); }
+
+  void Release() const noexcept {
+    if (count_.Decrement()) delete static_cast<const Derived*>(this);
+  }
+
+  size_t UseCount() const noexcept { return count_.Load(); }
+
+ protected:
+  RefCounted() noexcept = default;
+
+  // a copy is a different object, nobody refers to it yet
+  RefCounted(const RefCounted&) noexcept {}
+
+  RefCounted& operator=(const RefCounted&) noexcept { return *this; }
+
+  ~RefCounted() = default;
+
+ private:
+  mutable Count count_{0};
+};
+
+// T is anything with AddRef() and Release(), usually derived from RefCounted<T>.
+template <typename T>
+class IntrusivePtr {
+  template <typename U>
+  friend class IntrusivePtr;
+
+ public:
+  IntrusivePtr() noexcept = default;
+
+  // IntrusivePtr<Node> p(new Node);
+  // IntrusivePtr<Node> p(this);
+  explicit IntrusivePtr(T* data) noexcept : data_(data) {
+    if (data_) data_->AddRef();
+  }
+
+  IntrusivePtr(const IntrusivePtr& other) noexcept : data_(other.data_) {
+    if (data_) data_->AddRef();
+  }
+
+  IntrusivePtr(IntrusivePtr&& other) noexcept : data_(other.data_) { other.data_ = nullptr; }
+
+  template <typename U>
+  IntrusivePtr(const IntrusivePtr<U>& other) noexcept : data_(other.data_) {
+    if (data_) data_->AddRef();
+  }
+
+  ~IntrusivePtr() {
+    if (data_) data_->Release();
+  }
+
+  IntrusivePtr& operator=(const IntrusivePtr& other) noexcept {
+    IntrusivePtr tmp(other);
+    swap(tmp);
+    return *this;
+  }
+
+  IntrusivePtr& operator=(IntrusivePtr&& other) noexcept {
+    IntrusivePtr tmp(std::move(other));
+    swap(tmp);
+    return *this;
+  }
+
+  T& operator*() const noexcept {
+    assert(data_ != nullptr);
+    return *data_;
+  }
+
+  T* operator->() const noexcept {
+    assert(data_ != nullptr);
+    return data_;
+  }
+
+  explicit operator bool() const noexcept { return data_ != nullptr; }
+
+  T* Get() const noexcept { return data_; }
+
+  void Reset() noexcept { IntrusivePtr().swap(*this); }
+
+  void Reset(T* data) noexcept { IntrusivePtr(data).swap(*this); }
+
+  void swap(IntrusivePtr& other) noexcept {
+    using std::swap;
+    swap(data_, other.data_);
+  }
+
+ private:
+  T* data_ = nullptr;
+};
+
+#endif  // INTRUSIVE_PTR_H_
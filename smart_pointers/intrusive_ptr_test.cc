@@ -0,0 +1,113 @@
+#include "intrusive_ptr.h"
+
+#include <thread>
+#include <vector>
+
+struct Node : public RefCounted<Node> {
+  explicit Node(int value, int* destroyed = nullptr) : value(value), destroyed(destroyed) {}
+  ~Node() {
+    if (destroyed) ++*destroyed;
+  }
+  int value;
+  int* destroyed;
+};
+
+void TestIntrusivePtr() {
+  static_assert(sizeof(IntrusivePtr<Node>) == sizeof(Node*), "IntrusivePtr is one pointer");
+
+  {
+    IntrusivePtr<Node> ip1;
+    assert(ip1.Get() == nullptr);
+    assert(!ip1);
+  }
+
+  {
+    int destroyed = 0;
+    {
+      IntrusivePtr<Node> ip1(new Node(1, &destroyed));
+      assert(ip1->value == 1);
+      assert(ip1->UseCount() == 1);
+      IntrusivePtr<Node> ip2(ip1);
+      assert(ip1->UseCount() == 2);
+      IntrusivePtr<Node> ip3(std::move(ip2));
+      assert(!ip2);
+      assert(ip1->UseCount() == 2);
+    }
+    assert(destroyed == 1);
+  }
+
+  {
+    int destroyed = 0;
+    IntrusivePtr<Node> ip1(new Node(1, &destroyed));
+    IntrusivePtr<Node> ip2(new Node(2, &destroyed));
+    ip1 = ip2;
+    assert(destroyed == 1);
+    assert(ip1->value == 2);
+    ip1 = ip1;
+    assert(ip1->UseCount() == 2);
+    ip2 = std::move(ip1);
+    assert(ip2->UseCount() == 1);
+    ip2.Reset(new Node(3, &destroyed));
+    assert(destroyed == 2);
+    ip2.Reset();
+    assert(destroyed == 3);
+  }
+
+  // a raw pointer to a live object can be turned back into an owner
+  {
+    IntrusivePtr<Node> ip1(new Node(1));
+    Node* raw = ip1.Get();
+    IntrusivePtr<Node> ip2(raw);
+    assert(ip1->UseCount() == 2);
+  }
+
+  // copying the object does not copy its count
+  {
+    IntrusivePtr<Node> ip1(new Node(1));
+    IntrusivePtr<Node> ip2(ip1);
+    IntrusivePtr<Node> ip3(new Node(*ip1));
+    assert(ip3->UseCount() == 1);
+  }
+
+  {
+    struct Base : public RefCounted<Base> {
+      virtual ~Base() = default;
+    };
+    struct Derived : public Base {};
+    IntrusivePtr<Derived> ip1(new Derived);
+    IntrusivePtr<Base> ip2(ip1);
+    assert(ip2->UseCount() == 2);
+  }
+}
+
+struct SharedNode : public RefCounted<SharedNode, AtomicCount> {
+  explicit SharedNode(int* destroyed) : destroyed(destroyed) {}
+  ~SharedNode() { ++*destroyed; }
+  int* destroyed;
+};
+
+void TestAtomicCount() {
+  const int kThreads = 8;
+  const int kCopies = 100000;
+
+  int destroyed = 0;
+  IntrusivePtr<SharedNode> ip(new SharedNode(&destroyed));
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kThreads; ++i) {
+    threads.emplace_back([copy = ip, kCopies] {
+      for (int j = 0; j < kCopies; ++j) {
+        IntrusivePtr<SharedNode> tmp(copy);
+        assert(tmp.Get() == copy.Get());
+      }
+    });
+  }
+  ip.Reset();
+  for (auto& t : threads) t.join();
+  assert(destroyed == 1);
+}
+
+int main() {
+  TestIntrusivePtr();
+  TestAtomicCount();
+  return 0;
+}
@@ -0,0 +1,211 @@
+#ifndef POOL_ALLOCATOR_H_
+#define POOL_ALLOCATOR_H_
+
+#include <cstddef>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+
+// Size-class pool for small, short-lived allocations such as control blocks:
+//   void* p = PoolAlloc(48);
+//   PoolFree(p, 48);
+//   auto sp = AllocateShared<Foo>(PoolAllocator<Foo>(), args...);
+//
+// Sizes up to 256 bytes are rounded up to a multiple of 16. Each class has a free list per
+// thread, refilled from and drained to a central list under a mutex in batches of 32, so the
+// mutex is taken at most once per 32 allocations or frees. A block may be freed by a different
+// thread from the one that allocated it. The central lists are filled by carving 64KB chunks
+// from malloc. Chunks are never returned, so the pool holds on to its high-water mark. Larger
+// sizes go to operator new.
+
+namespace pool_internal {
+
+constexpr size_t kAlign = 16;
+constexpr size_t kClasses = 16;
+constexpr size_t kMaxSize = kAlign * kClasses;
+constexpr size_t kBatch = 32;
+constexpr size_t kChunkSize = 64 * 1024;
+
+struct FreeBlock {
+  FreeBlock* next;
+};
+
+// size 0 shares the smallest class, so that every allocation is a distinct block
+inline size_t ClassOf(size_t size) { return size == 0 ? 0 : (size + kAlign - 1) / kAlign - 1; }
+
+inline size_t SizeOf(size_t cls) { return (cls + 1) * kAlign; }
+
+class Central {
+ public:
+  // never destroyed, blocks may be freed by static destructors
+  static Central& Instance() {
+    static Central* central = new Central;
+    return *central;
+  }
+
+  // Takes up to n blocks of class cls, carving a new chunk if the list is empty. Returns the
+  // chain and its length in *count.
+  FreeBlock* Take(size_t cls, size_t n, size_t* count) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!heads_[cls]) Carve(cls);
+    FreeBlock* head = heads_[cls];
+    FreeBlock* tail = head;
+    *count = 1;
+    while (*count < n && tail->next) {
+      tail = tail->next;
+      ++*count;
+    }
+    heads_[cls] = tail->next;
+    tail->next = nullptr;
+    return head;
+  }
+
+  void Give(size_t cls, FreeBlock* head) {
+    FreeBlock* tail = head;
+    while (tail->next) tail = tail->next;
+    std::lock_guard<std::mutex> lock(mutex_);
+    tail->next = heads_[cls];
+    heads_[cls] = head;
+  }
+
+ private:
+  void Carve(size_t cls) {
+    size_t size = SizeOf(cls);
+    char* chunk = static_cast<char*>(malloc(kChunkSize));
+    if (!chunk) throw std::bad_alloc();
+    FreeBlock* head = nullptr;
+    for (size_t offset = kChunkSize / size * size; offset != 0; offset -= size) {
+      FreeBlock* block = reinterpret_cast<FreeBlock*>(chunk + offset - size);
+      block->next = head;
+      head = block;
+    }
+    heads_[cls] = head;
+  }
+
+  std::mutex mutex_;
+  FreeBlock* heads_[kClasses] = {};
+};
+
+class ThreadCache {
+ public:
+  ThreadCache() = default;
+
+  ThreadCache(const ThreadCache& other) = delete;
+
+  ThreadCache& operator=(const ThreadCache& other) = delete;
+
+  ~ThreadCache() {
+    for (size_t cls = 0; cls < kClasses; ++cls) {
+      if (heads_[cls]) Central::Instance().Give(cls, heads_[cls]);
+    }
+  }
+
+  void* Alloc(size_t cls) {
+    if (!heads_[cls]) heads_[cls] = Central::Instance().Take(cls, kBatch, &counts_[cls]);
+    FreeBlock* block = heads_[cls];
+    heads_[cls] = block->next;
+    --counts_[cls];
+    return block;
+  }
+
+  void Free(size_t cls, void* p) {
+    FreeBlock* block = static_cast<FreeBlock*>(p);
+    block->next = heads_[cls];
+    heads_[cls] = block;
+    if (++counts_[cls] < 2 * kBatch) return;
+
+    // keep one batch, hand the other back
+    FreeBlock* tail = heads_[cls];
+    for (size_t i = 1; i < kBatch; ++i) tail = tail->next;
+    Central::Instance().Give(cls, tail->next);
+    tail->next = nullptr;
+    counts_[cls] = kBatch;
+  }
+
+ private:
+  FreeBlock* heads_[kClasses] = {};
+  size_t counts_[kClasses] = {};
+};
+
+// The thread's cache, or nullptr once it has been destroyed at thread exit, after which the
+// thread goes straight to the central lists.
+inline ThreadCache* Cache() {
+  // 0: not created yet, 1: live, 2: destroyed
+  static thread_local int state = 0;
+  struct Holder {
+    ~Holder() { state = 2; }
+    ThreadCache cache;
+  };
+  if (state == 2) return nullptr;
+  static thread_local Holder holder;
+  state = 1;
+  return &holder.cache;
+}
+
+}  // namespace pool_internal
+
+inline void* PoolAlloc(size_t size) {
+  if (size > pool_internal::kMaxSize) return ::operator new(size);
+  size_t cls = pool_internal::ClassOf(size);
+  if (pool_internal::ThreadCache* cache = pool_internal::Cache()) return cache->Alloc(cls);
+  size_t count;
+  return pool_internal::Central::Instance().Take(cls, 1, &count);
+}
+
+// size must be the size p was allocated with
+inline void PoolFree(void* p, size_t size) noexcept {
+  if (size > pool_internal::kMaxSize) {
+    ::operator delete(p);
+    return;
+  }
+  size_t cls = pool_internal::ClassOf(size);
+  if (pool_internal::ThreadCache* cache = pool_internal::Cache()) {
+    cache->Free(cls, p);
+  } else {
+    pool_internal::FreeBlock* block = static_cast<pool_internal::FreeBlock*>(p);
+    block->next = nullptr;
+    pool_internal::Central::Instance().Give(cls, block);
+  }
+}
+
+// Standard allocator over PoolAlloc/PoolFree, for AllocateShared(), SharedPtr's deleter
+// constructors and containers. Types aligned to more than 16 bytes are not supported.
+template <typename T>
+class PoolAllocator {
+ public:
+  using value_type = T;
+
+  static_assert(alignof(T) <= pool_internal::kAlign, "over-aligned type");
+
+  PoolAllocator() noexcept = default;
+
+  template <typename U>
+  PoolAllocator(const PoolAllocator<U>&) noexcept {}
+
+  T* allocate(size_t n) { return static_cast<T*>(PoolAlloc(n * sizeof(T))); }
+
+  void deallocate(T* p, size_t n) noexcept { PoolFree(p, n * sizeof(T)); }
+
+  template <typename U>
+  bool operator==(const PoolAllocator<U>&) const noexcept {
+    return true;
+  }
+
+  template <typename U>
+  bool operator!=(const PoolAllocator<U>&) const noexcept {
+    return false;
+  }
+};
+
+// Deleter for an object constructed in PoolAlloc(sizeof(T)), for UniquePtr and SharedPtr:
+//   UniquePtr<Foo, PoolDelete<Foo>> up(new (PoolAlloc(sizeof(Foo))) Foo(args...));
+// T must be the object's dynamic type, since the size freed is sizeof(T).
+template <typename T>
+struct PoolDelete {
+  void operator()(T* data) const noexcept {
+    data->~T();
+    PoolFree(data, sizeof(T));
+  }
+};
+
+#endif  // POOL_ALLOCATOR_H_
@@ -0,0 +1,127 @@
+#include "pool_allocator.h"
+
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "count_new.h"
+#include "shared_ptr.h"
+
+void TestPool() {
+  // blocks are reused, distinct while live and 16-byte aligned
+  {
+    void* p = PoolAlloc(24);
+    PoolFree(p, 24);
+    void* q = PoolAlloc(32);
+    assert(q == p);
+    void* r = PoolAlloc(32);
+    assert(r != q);
+    assert(reinterpret_cast<uintptr_t>(r) % 16 == 0);
+    PoolFree(q, 32);
+    PoolFree(r, 32);
+  }
+
+  // more than a chunk and more than a thread cache holds
+  {
+    std::vector<void*> blocks;
+    for (int i = 0; i < 10000; ++i) {
+      blocks.push_back(PoolAlloc(64));
+      memset(blocks.back(), i, 64);
+    }
+    for (int i = 0; i < 10000; ++i) {
+      assert(*static_cast<unsigned char*>(blocks[i]) == static_cast<unsigned char>(i));
+      PoolFree(blocks[i], 64);
+    }
+  }
+
+  {
+    void* p = PoolAlloc(1000);
+    PoolFree(p, 1000);
+  }
+
+  // zero bytes still get distinct blocks from the smallest class
+  {
+    PoolAllocator<int> alloc;
+    int* p = alloc.allocate(0);
+    int* q = alloc.allocate(0);
+    assert(p && q && p != q);
+    alloc.deallocate(p, 0);
+    alloc.deallocate(q, 0);
+    void* r = PoolAlloc(0);
+    PoolFree(r, 0);
+  }
+}
+
+// blocks allocated on one thread and freed on another
+void TestCrossThread() {
+  const int kRounds = 100;
+  const int kBlocks = 1000;
+
+  for (int round = 0; round < kRounds; ++round) {
+    std::vector<void*> blocks;
+    std::thread producer([&blocks] {
+      for (int i = 0; i < kBlocks; ++i) blocks.push_back(PoolAlloc(48));
+    });
+    producer.join();
+    std::thread consumer([&blocks] {
+      for (void* p : blocks) PoolFree(p, 48);
+    });
+    consumer.join();
+  }
+}
+
+struct Counted {
+  explicit Counted(int* destroyed) : destroyed(destroyed) {}
+  ~Counted() { ++*destroyed; }
+  int* destroyed;
+};
+
+void TestSharedPtr() {
+  {
+    int destroyed = 0;
+    SharedPtr<Counted> sp1 = AllocateShared<Counted>(PoolAllocator<Counted>(), &destroyed);
+    SharedPtr<Counted> sp2(sp1);
+    sp1.Reset();
+    sp2.Reset();
+    assert(destroyed == 1);
+  }
+
+  // once the pool is warm, neither the block nor the object touches operator new
+  {
+    int destroyed = 0;
+    uint64_t before = Allocations();
+    for (int i = 0; i < 1000; ++i) {
+      SharedPtr<Counted> sp = AllocateShared<Counted>(PoolAllocator<Counted>(), &destroyed);
+    }
+    assert(Allocations() == before);
+    assert(destroyed == 1000);
+  }
+
+  // an object from some other pool, with its control block from this one
+  {
+    int destroyed = 0;
+    int released = 0;
+    alignas(Counted) unsigned char arena[sizeof(Counted)];
+    {
+      auto release = [&released](Counted* counted) {
+        counted->~Counted();
+        ++released;
+      };
+      uint64_t before = Allocations();
+      SharedPtr<Counted> sp(new (arena) Counted(&destroyed), release, PoolAllocator<Counted>());
+      assert(Allocations() == before);
+      SharedPtr<Counted> sp2(sp);
+    }
+    assert(destroyed == 1);
+    assert(released == 1);
+  }
+}
+
+int main() {
+  TestPool();
+  TestCrossThread();
+  TestSharedPtr();
+  return 0;
+}
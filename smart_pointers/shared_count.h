@@ -2,10 +2,219 @@
 #define SHARED_COUNT_H_
 
 #include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
 
-struct SharedCount {
-  size_t shared_count = 1;
-  size_t weak_count = 0;
+// Reference count policies for SharedPtr/WeakPtr:
+//   SharedPtr<Foo> p;               // NonAtomicCount: one thread only, plain ++/--
+//   SharedPtr<Foo, AtomicCount> q;  // copies may be made and dropped on any thread
+// Both offer the same operations. Decrement() returns true when the count drops to zero, and
+// IncrementIfNonzero() takes a reference only while the count is still positive (WeakPtr::Lock()).
+
+class NonAtomicCount {
+ public:
+  explicit NonAtomicCount(size_t count) noexcept : count_(count) {}
+
+  void Increment() noexcept { ++count_; }
+
+  bool Decrement() noexcept { return --count_ == 0; }
+
+  bool IncrementIfNonzero() noexcept {
+    if (count_ == 0) return false;
+    ++count_;
+    return true;
+  }
+
+  size_t Load() const noexcept { return count_; }
+
+ private:
+  size_t count_;
+};
+
+class AtomicCount {
+ public:
+  explicit AtomicCount(size_t count) noexcept : count_(count) {}
+
+  // A new reference is always made from an existing one, so there is nothing to order.
+  void Increment() noexcept { __atomic_fetch_add(&count_, 1, __ATOMIC_RELAXED); }
+
+  // Adds n references at once, for AtomicSharedPtr handing over its borrowed ones. n may be a
+  // negative number converted to size_t.
+  void Add(size_t n) noexcept { __atomic_fetch_add(&count_, n, __ATOMIC_RELAXED); }
+
+  // Release, so that every owner's writes to the object happen before the last owner destroys
+  // it, and acquire for the last owner, which goes on to destroy it. A release decrement plus an
+  // acquire fence on zero would do, but costs the same lock xadd on x86 and is opaque to TSan.
+  bool Decrement() noexcept { return __atomic_sub_fetch(&count_, 1, __ATOMIC_ACQ_REL) == 0; }
+
+  bool IncrementIfNonzero() noexcept {
+    size_t count = __atomic_load_n(&count_, __ATOMIC_RELAXED);
+    do {
+      if (count == 0) return false;
+    } while (!__atomic_compare_exchange_n(&count_, &count, count + 1, true, __ATOMIC_RELAXED,
+                                          __ATOMIC_RELAXED));
+    return true;
+  }
+
+  size_t Load() const noexcept { return __atomic_load_n(&count_, __ATOMIC_ACQUIRE); }
+
+ private:
+  size_t count_;
+};
+
+template <typename Count>
+class SharedCount;
+
+// How SharedCount uses a count policy: Weak is the policy for weak_count, and Attach() lets a
+// policy that needs to reach its block learn where it is.
+template <typename Count>
+struct CountTraits {
+  using Weak = Count;
+
+  static void Attach(Count*, SharedCount<Count>*) noexcept {}
+};
+
+// Control block shared by the SharedPtrs and WeakPtrs of one object. weak_count is the number of
+// WeakPtrs plus one held by all SharedPtrs together, so the block is freed by whoever drops
+// weak_count to zero, whether that is a SharedPtr or a WeakPtr.
+template <typename Count = NonAtomicCount>
+class SharedCount {
+ public:
+  SharedCount() noexcept { CountTraits<Count>::Attach(&shared_count, this); }
+
+  SharedCount(const SharedCount& other) = delete;
+
+  SharedCount& operator=(const SharedCount& other) = delete;
+
+  void Release() noexcept {
+    if (shared_count.Decrement()) Expire();
+  }
+
+  // shared_count has reached zero
+  void Expire() noexcept {
+    Dispose();
+    WeakRelease();
+  }
+
+  void WeakRelease() noexcept {
+    if (weak_count.Decrement()) Destroy();
+  }
+
+  Count shared_count{1};
+  typename CountTraits<Count>::Weak weak_count{1};
+
+ protected:
+  ~SharedCount() = default;
+
+ private:
+  // destroys the object, when shared_count drops to zero
+  virtual void Dispose() noexcept = 0;
+
+  // frees the block, when weak_count drops to zero
+  virtual void Destroy() noexcept = 0;
+};
+
+// Block for SharedPtr(new T): the object lives in its own allocation.
+template <typename T, typename Count>
+class SharedCountPtr final : public SharedCount<Count> {
+ public:
+  explicit SharedCountPtr(T* data) noexcept : data_(data) {}
+
+ private:
+  void Dispose() noexcept override { delete data_; }
+
+  void Destroy() noexcept override { delete this; }
+
+  T* data_;
+};
+
+// Block for MakeShared<T>(): the object is constructed inside the block, one allocation for both
+// and the count on the same cache line as the start of the object. The memory is only returned
+// once the last WeakPtr is gone too.
+template <typename T, typename Count>
+class SharedCountInplace final : public SharedCount<Count> {
+ public:
+  template <typename... Args>
+  explicit SharedCountInplace(Args&&... args) {
+    new (storage_) T(std::forward<Args>(args)...);
+  }
+
+  T* Get() noexcept { return std::launder(reinterpret_cast<T*>(storage_)); }
+
+ private:
+  void Dispose() noexcept override { Get()->~T(); }
+
+  void Destroy() noexcept override { delete this; }
+
+  alignas(T) unsigned char storage_[sizeof(T)];
+};
+
+// Control blocks with an allocator are allocated and freed through Alloc rebound to the block
+// type, so the block itself can come from a pool.
+template <typename Block, typename Alloc, typename... Args>
+Block* AllocateBlock(const Alloc& alloc, Args&&... args) {
+  using BlockAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<Block>;
+  BlockAlloc block_alloc(alloc);
+  Block* block = std::allocator_traits<BlockAlloc>::allocate(block_alloc, 1);
+  try {
+    return new (block) Block(std::forward<Args>(args)...);
+  } catch (...) {
+    std::allocator_traits<BlockAlloc>::deallocate(block_alloc, block, 1);
+    throw;
+  }
+}
+
+template <typename Block, typename Alloc>
+void DeallocateBlock(Block* block, const Alloc& alloc) noexcept {
+  using BlockAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<Block>;
+  BlockAlloc block_alloc(alloc);
+  block->~Block();
+  std::allocator_traits<BlockAlloc>::deallocate(block_alloc, block, 1);
+}
+
+// Block for SharedPtr(data, deleter, alloc): the object is released by calling deleter(data),
+// e.g. to return it to an arena.
+template <typename T, typename Deleter, typename Alloc, typename Count>
+class SharedCountDeleter final : public SharedCount<Count> {
+ public:
+  SharedCountDeleter(T* data, Deleter deleter, const Alloc& alloc) noexcept
+      : data_(data), deleter_(std::move(deleter)), alloc_(alloc) {}
+
+ private:
+  void Dispose() noexcept override { deleter_(data_); }
+
+  void Destroy() noexcept override {
+    Alloc alloc(alloc_);
+    DeallocateBlock(this, alloc);
+  }
+
+  T* data_;
+  Deleter deleter_;
+  Alloc alloc_;
+};
+
+// Block for AllocateShared<T>(alloc, args...): SharedCountInplace allocated from alloc.
+template <typename T, typename Alloc, typename Count>
+class SharedCountInplaceAlloc final : public SharedCount<Count> {
+ public:
+  template <typename... Args>
+  explicit SharedCountInplaceAlloc(const Alloc& alloc, Args&&... args) : alloc_(alloc) {
+    new (storage_) T(std::forward<Args>(args)...);
+  }
+
+  T* Get() noexcept { return std::launder(reinterpret_cast<T*>(storage_)); }
+
+ private:
+  void Dispose() noexcept override { Get()->~T(); }
+
+  void Destroy() noexcept override {
+    Alloc alloc(alloc_);
+    DeallocateBlock(this, alloc);
+  }
+
+  alignas(T) unsigned char storage_[sizeof(T)];
+  Alloc alloc_;
 };
 
 #endif  // SHARED_COUNT_H_
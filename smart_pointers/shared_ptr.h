@@ -2,21 +2,39 @@
 #define SHARED_PTR_H_
 
 #include <cassert>
+#include <memory>
 #include <utility>
 
 #include "shared_count.h"
 
-template <typename T>
+template <typename T, typename Count>
 class WeakPtr;
 
 template <typename T>
+class AtomicSharedPtr;
+
+template <typename T, typename Count>
+class EnableSharedFromThis;
+
+// Count is the reference count policy from shared_count.h. The default NonAtomicCount keeps every
+// copy on one thread; use AtomicCount for pointers that are copied and dropped across threads.
+template <typename T, typename Count = NonAtomicCount>
 class SharedPtr {
-  template <typename U>
+  template <typename U, typename C>
   friend class SharedPtr;
 
-  template <typename U>
+  template <typename U, typename C>
   friend class WeakPtr;
 
+  template <typename U>
+  friend class AtomicSharedPtr;
+
+  template <typename U, typename C, typename... Args>
+  friend SharedPtr<U, C> MakeShared(Args&&... args);
+
+  template <typename U, typename C, typename Alloc, typename... Args>
+  friend SharedPtr<U, C> AllocateShared(const Alloc& alloc, Args&&... args);
+
  public:
   SharedPtr() noexcept = default;
 
@@ -24,23 +42,56 @@ class SharedPtr {
   // SharedPtr<int> sp(new int(2022));
   explicit SharedPtr(T* data) : data_(data) {
     if (data_) {
-      count_ = new SharedCount;
+      count_ = new SharedCountPtr<T, Count>(data_);
+      EnableWeakThis(data_);
+    }
+  }
+
+  // The object is released with deleter(data) instead of delete, and the control block comes
+  // from alloc. If the block cannot be allocated, deleter(data) is called before rethrowing.
+  //   SharedPtr<Foo> sp(arena.New<Foo>(), [&arena](Foo* foo) { arena.Delete(foo); });
+  //   SharedPtr<Foo> sp(new Foo, std::default_delete<Foo>(), PoolAllocator<Foo>());
+  template <typename Deleter, typename Alloc = std::allocator<T>>
+  SharedPtr(T* data, Deleter deleter, const Alloc& alloc = Alloc()) : data_(data) {
+    if (!data_) return;
+    try {
+      count_ = AllocateBlock<SharedCountDeleter<T, Deleter, Alloc, Count>>(alloc, data_, deleter,
+                                                                           alloc);
+    } catch (...) {
+      deleter(data_);
+      throw;
     }
+    EnableWeakThis(data_);
   }
 
   SharedPtr(const SharedPtr& other) noexcept : data_(other.data_), count_(other.count_) {
-    if (count_) ++count_->shared_count;
+    if (count_) count_->shared_count.Increment();
   }
 
-  SharedPtr(SharedPtr&& other) { swap(other); }
+  SharedPtr(SharedPtr&& other) noexcept { swap(other); }
 
   template <typename U>
-  SharedPtr(const SharedPtr<U>& other) noexcept : data_(other.data_), count_(other.count_) {
-    if (count_) ++count_->shared_count;
+  SharedPtr(const SharedPtr<U, Count>& other) noexcept : data_(other.data_), count_(other.count_) {
+    if (count_) count_->shared_count.Increment();
   }
 
-  explicit SharedPtr(const WeakPtr<T>& other) noexcept : data_(other.data_), count_(other.count_) {
-    if (count_) ++count_->shared_count;
+  // Aliasing: points to data but shares owner's control block, so data stays valid as long as
+  // the object owner points to does. Nothing is allocated.
+  //   SharedPtr<Foo> foo = MakeShared<Foo>();
+  //   SharedPtr<Bar> bar(foo, &foo->bar);
+  template <typename U>
+  SharedPtr(const SharedPtr<U, Count>& owner, T* data) noexcept
+      : data_(data), count_(owner.count_) {
+    if (count_) count_->shared_count.Increment();
+  }
+
+  // Empty if other has expired. The count is taken with IncrementIfNonzero(), so with
+  // AtomicCount this is safe against the last SharedPtr being dropped on another thread.
+  explicit SharedPtr(const WeakPtr<T, Count>& other) noexcept {
+    if (other.count_ && other.count_->shared_count.IncrementIfNonzero()) {
+      data_ = other.data_;
+      count_ = other.count_;
+    }
   }
 
   ~SharedPtr() { Decrement(); }
@@ -70,7 +121,7 @@ class SharedPtr {
     return *data_;
   }
 
-  T& operator->() const noexcept {
+  T* operator->() const noexcept {
     assert(data_ != nullptr);
     return data_;
   }
@@ -88,7 +139,16 @@ class SharedPtr {
   void Reset(T* data) {
     Decrement();
     data_ = data;
-    count_ = new SharedCount;
+    count_ = nullptr;
+    if (data_) {
+      count_ = new SharedCountPtr<T, Count>(data_);
+      EnableWeakThis(data_);
+    }
+  }
+
+  template <typename Deleter, typename Alloc = std::allocator<T>>
+  void Reset(T* data, Deleter deleter, const Alloc& alloc = Alloc()) {
+    SharedPtr(data, std::move(deleter), alloc).swap(*this);
   }
 
   void swap(SharedPtr& other) noexcept {
@@ -98,23 +158,52 @@ class SharedPtr {
   }
 
  private:
-  void Decrement() noexcept {
-    if (!count_) return;
+  // adopts a reference already counted in count; count comes first to stay clear of the deleter
+  // constructor
+  SharedPtr(SharedCount<Count>* count, T* data) noexcept : data_(data), count_(count) {}
 
-    --count_->shared_count;
-
-    if (count_->shared_count == 0) {
-      delete data_;
-      data_ = nullptr;
-      if (count_->weak_count == 0) {
-        delete count_;
-        count_ = nullptr;
-      }
+  // Points the object's EnableSharedFromThis base at this new owner, unless another owner has
+  // claimed it already.
+  template <typename U>
+  void EnableWeakThis(const EnableSharedFromThis<U, Count>* base) noexcept {
+    // through the aliasing constructor, since T may be const U
+    if (base->weak_this_.Expired()) {
+      base->weak_this_ = SharedPtr<U, Count>(*this, const_cast<U*>(static_cast<const U*>(data_)));
     }
   }
 
+  // no EnableSharedFromThis base with the same Count
+  void EnableWeakThis(...) noexcept {}
+
+  void Decrement() noexcept {
+    if (count_) count_->Release();
+  }
+
   T* data_ = nullptr;
-  SharedCount* count_ = nullptr;
+  SharedCount<Count>* count_ = nullptr;
 };
 
+// Constructs the object and its count in a single allocation:
+//   auto sp = MakeShared<std::string>(10, 'x');
+//   auto sp = MakeShared<Foo, AtomicCount>(arg);
+template <typename T, typename Count = NonAtomicCount, typename... Args>
+SharedPtr<T, Count> MakeShared(Args&&... args) {
+  auto count = new SharedCountInplace<T, Count>(std::forward<Args>(args)...);
+  SharedPtr<T, Count> sp(count, count->Get());
+  sp.EnableWeakThis(sp.data_);
+  return sp;
+}
+
+// MakeShared with the block, object included, allocated from alloc:
+//   auto sp = AllocateShared<Foo>(PoolAllocator<Foo>(), arg);
+template <typename T, typename Count = NonAtomicCount, typename Alloc, typename... Args>
+SharedPtr<T, Count> AllocateShared(const Alloc& alloc, Args&&... args) {
+  auto count =
+      AllocateBlock<SharedCountInplaceAlloc<T, Alloc, Count>>(alloc, alloc,
+                                                              std::forward<Args>(args)...);
+  SharedPtr<T, Count> sp(count, count->Get());
+  sp.EnableWeakThis(sp.data_);
+  return sp;
+}
+
 #endif  // SHARED_PTR_H_
@@ -1,5 +1,12 @@
 #include "shared_ptr.h"
 
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "enable_shared_from_this.h"
+#include "weak_ptr.h"
+
 void TestSharedPtr() {
   {
     SharedPtr<int> sp1;
@@ -76,7 +83,217 @@ void TestSharedPtr() {
   }
 }
 
+struct Counted {
+  explicit Counted(int* destroyed) : destroyed(destroyed) {}
+  ~Counted() { ++*destroyed; }
+  int* destroyed;
+};
+
+void TestMakeShared() {
+  {
+    SharedPtr<std::string> sp1 = MakeShared<std::string>(3, 'x');
+    assert(*sp1 == "xxx");
+    assert(sp1->size() == 3);
+    SharedPtr<std::string> sp2(sp1);
+    assert(sp2.Get() == sp1.Get());
+  }
+
+  // the object goes with the last SharedPtr even though a WeakPtr keeps the block alive
+  {
+    int destroyed = 0;
+    SharedPtr<Counted> sp1 = MakeShared<Counted>(&destroyed);
+    WeakPtr<Counted> wp1(sp1);
+    sp1.Reset();
+    assert(destroyed == 1);
+    assert(wp1.Expired());
+    assert(!wp1.Lock());
+  }
+
+  // the block remembers the real type, so no virtual destructor is needed in Base
+  {
+    struct Base {};
+    struct Derived : Base {
+      explicit Derived(int* destroyed) : counted(destroyed) {}
+      Counted counted;
+    };
+    int destroyed = 0;
+    {
+      SharedPtr<Base> sp1(MakeShared<Derived>(&destroyed));
+      SharedPtr<Base> sp2(SharedPtr<Derived>(new Derived(&destroyed)));
+    }
+    assert(destroyed == 2);
+  }
+}
+
+void TestDeleter() {
+  {
+    int destroyed = 0;
+    int released = 0;
+    {
+      Counted* counted = new Counted(&destroyed);
+      SharedPtr<Counted> sp1(counted, [&released](Counted* counted) {
+        ++released;
+        delete counted;
+      });
+      SharedPtr<Counted> sp2(sp1);
+      sp1.Reset();
+      assert(released == 0);
+    }
+    assert(destroyed == 1);
+    assert(released == 1);
+  }
+
+  {
+    int destroyed = 0;
+    SharedPtr<Counted> sp1(new Counted(&destroyed));
+    sp1.Reset(new Counted(&destroyed), std::default_delete<Counted>());
+    assert(destroyed == 1);
+    sp1.Reset();
+    assert(destroyed == 2);
+  }
+
+  {
+    int destroyed = 0;
+    {
+      SharedPtr<Counted> sp1 = AllocateShared<Counted>(std::allocator<Counted>(), &destroyed);
+      WeakPtr<Counted> wp1(sp1);
+    }
+    assert(destroyed == 1);
+  }
+}
+
+void TestAliasing() {
+  struct Pair {
+    explicit Pair(int* destroyed) : first(destroyed), second(destroyed) {}
+    Counted first;
+    Counted second;
+  };
+
+  int destroyed = 0;
+  SharedPtr<Pair> pair = MakeShared<Pair>(&destroyed);
+  SharedPtr<Counted> second(pair, &pair->second);
+  assert(second.Get() == &pair->second);
+
+  // the member keeps the whole object alive
+  pair.Reset();
+  assert(destroyed == 0);
+  WeakPtr<Counted> wp(second);
+  assert(wp.Lock().Get() == second.Get());
+  second.Reset();
+  assert(destroyed == 2);
+  assert(wp.Expired());
+
+  // an empty owner leaves nothing to keep alive
+  int value = 1;
+  SharedPtr<int> sp1(SharedPtr<Pair>(), &value);
+  assert(*sp1 == 1);
+}
+
+void TestEnableSharedFromThis() {
+  struct Node : EnableSharedFromThis<Node> {
+    explicit Node(int* destroyed) : counted(destroyed) {}
+    Counted counted;
+  };
+  struct Leaf : Node {
+    using Node::Node;
+  };
+
+  for (int i = 0; i < 3; ++i) {
+    int destroyed = 0;
+    {
+      SharedPtr<Node> sp1;
+      if (i == 0) sp1 = MakeShared<Node>(&destroyed);
+      if (i == 1) sp1.Reset(new Node(&destroyed));
+      if (i == 2) sp1 = AllocateShared<Node>(std::allocator<Node>(), &destroyed);
+      SharedPtr<Node> sp2 = sp1->SharedFromThis();
+      assert(sp2.Get() == sp1.Get());
+      sp1.Reset();
+      assert(destroyed == 0);
+      const Node& node = *sp2;
+      SharedPtr<const Node> sp3 = node.SharedFromThis();
+      assert(sp3.Get() == sp2.Get());
+      assert(!node.WeakFromThis().Expired());
+    }
+    assert(destroyed == 1);
+  }
+
+  // through a derived class, with a custom deleter
+  {
+    int destroyed = 0;
+    {
+      SharedPtr<Leaf> sp1(new Leaf(&destroyed), std::default_delete<Leaf>());
+      SharedPtr<Node> sp2 = sp1->SharedFromThis();
+      assert(sp2.Get() == sp1.Get());
+    }
+    assert(destroyed == 1);
+  }
+
+  // not owned yet, and a copy is not owned either
+  {
+    int destroyed = 0;
+    Node* node = new Node(&destroyed);
+    assert(!node->SharedFromThis());
+    SharedPtr<Node> sp1(node);
+    Node copy(*node);
+    assert(!copy.SharedFromThis());
+    WeakPtr<Node> wp = node->WeakFromThis();
+    assert(wp.Lock().Get() == node);
+  }
+
+  // a second owner does not take over: SharedFromThis() still shares the first one's block
+  {
+    int destroyed = 0;
+    Node* node = new Node(&destroyed);
+    SharedPtr<Node> sp1(node);
+    SharedPtr<Node> sp2(node, [](Node*) {});
+    SharedPtr<Node> sp3 = node->SharedFromThis();
+    sp1.Reset();
+    assert(destroyed == 0);
+    sp3.Reset();
+    assert(destroyed == 1);
+  }
+
+  // const owners
+  {
+    int destroyed = 0;
+    {
+      SharedPtr<const Node> sp1(new Node(&destroyed));
+      SharedPtr<const Node> sp2 = MakeShared<const Node>(&destroyed);
+      assert(sp1->SharedFromThis().Get() == sp1.Get());
+      assert(sp2->SharedFromThis().Get() == sp2.Get());
+    }
+    assert(destroyed == 2);
+  }
+}
+
+// Threads keep copying and dropping the same pointer; the object must be destroyed exactly once,
+// after the last copy is gone.
+void TestAtomicCount() {
+  const int kThreads = 8;
+  const int kCopies = 100000;
+
+  int destroyed = 0;
+  SharedPtr<Counted, AtomicCount> sp(new Counted(&destroyed));
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kThreads; ++i) {
+    threads.emplace_back([copy = sp, kCopies]() mutable {
+      for (int j = 0; j < kCopies; ++j) {
+        SharedPtr<Counted, AtomicCount> tmp(copy);
+        assert(tmp.Get() == copy.Get());
+      }
+    });
+  }
+  sp.Reset();
+  for (auto& t : threads) t.join();
+  assert(destroyed == 1);
+}
+
 int main() {
   TestSharedPtr();
+  TestMakeShared();
+  TestDeleter();
+  TestAliasing();
+  TestEnableSharedFromThis();
+  TestAtomicCount();
   return 0;
 }
@@ -0,0 +1,314 @@
+// UniquePtr, SharedPtr and WeakPtr against std::unique_ptr, std::shared_ptr and std::weak_ptr:
+// ns and operator new calls per operation, for construct, copy, move, destroy, Lock() and
+// push_back into a vector without reserve(). SharedPtr runs with NonAtomicCount and AtomicCount,
+// std::shared_ptr always counts atomically in a program linked with -pthread. The cross-thread
+// rows copy and drop, or Lock() and drop, one pointer from several threads at once, where only
+// AtomicCount is safe. The handoff rows copy or make pointers on one thread and drop them on
+// another, where BiasedCount takes its slow path and DeferredDelete moves the destructor away.
+//   g++ -std=c++17 -O2 -pthread -I../message_queue smart_ptr_bench.cc -o smart_ptr_bench
+//   ./smart_ptr_bench [objects] [threads]
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "biased_count.h"
+#include "count_new.h"
+#include "deferred_delete.h"
+#include "shared_ptr.h"
+#include "unique_ptr.h"
+#include "weak_ptr.h"
+
+struct Payload {
+  uint64_t values[4] = {};
+};
+
+struct Std {
+  template <typename T>
+  using Unique = std::unique_ptr<T>;
+  template <typename T>
+  using Shared = std::shared_ptr<T>;
+  template <typename T>
+  using Weak = std::weak_ptr<T>;
+
+  template <typename T>
+  static Shared<T> Make() {
+    return std::make_shared<T>();
+  }
+
+  template <typename T>
+  static Shared<T> Lock(const Weak<T>& weak) {
+    return weak.lock();
+  }
+
+  static void Drain() {}
+};
+
+template <typename Count>
+struct Ours {
+  template <typename T>
+  using Unique = UniquePtr<T>;
+  template <typename T>
+  using Shared = SharedPtr<T, Count>;
+  template <typename T>
+  using Weak = WeakPtr<T, Count>;
+
+  template <typename T>
+  static Shared<T> Make() {
+    return MakeShared<T, Count>();
+  }
+
+  template <typename T>
+  static Shared<T> Lock(const Weak<T>& weak) {
+    return weak.Lock();
+  }
+
+  static void Drain() {}
+};
+
+// the owner merges the blocks other threads dropped
+struct OursBiased : Ours<BiasedCount> {
+  static void Drain() { BiasedCount::Drain(); }
+};
+
+// destructors run on the reclaimer thread
+struct OursDeferred : Ours<AtomicCount> {
+  template <typename T>
+  static Shared<T> Make() {
+    return Shared<T>(new T, DeferredDelete<T>());
+  }
+};
+
+struct Cost {
+  double ns;
+  double allocs;
+};
+
+// runs fn, which does ops operations
+template <typename Fn>
+Cost Measure(size_t ops, Fn fn) {
+  uint64_t before = Allocations();
+  auto start = std::chrono::steady_clock::now();
+  fn();
+  double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start)
+                  .count();
+  uint64_t after = Allocations();
+  return {ns / ops, static_cast<double>(after - before) / ops};
+}
+
+// costs of one pointer type, in the order of the row names below
+using Costs = std::vector<Cost>;
+
+template <typename P>
+Costs UniqueCosts(size_t n) {
+  using Unique = typename P::template Unique<Payload>;
+  std::vector<Unique> ptrs, moved, grown;
+  ptrs.reserve(n);
+  moved.reserve(n);
+  Costs costs;
+  costs.push_back(Measure(n, [&] {
+    for (size_t i = 0; i < n; ++i) ptrs.emplace_back(new Payload);
+  }));
+  costs.push_back(Measure(n, [&] {
+    for (Unique& ptr : ptrs) moved.push_back(std::move(ptr));
+  }));
+  costs.push_back(Measure(n, [&] {
+    for (Unique& ptr : moved) grown.push_back(std::move(ptr));
+  }));
+  costs.push_back(Measure(n, [&] { grown.clear(); }));
+  return costs;
+}
+
+const char* const kUniqueRows[] = {"new+construct", "move", "vector growth", "destroy"};
+
+template <typename P>
+Costs SharedCosts(size_t n) {
+  using Shared = typename P::template Shared<Payload>;
+  using Weak = typename P::template Weak<Payload>;
+  std::vector<Shared> owners, made, copies, moved, grown;
+  std::vector<Weak> weaks;
+  owners.reserve(n);
+  made.reserve(n);
+  copies.reserve(n);
+  moved.reserve(n);
+  weaks.reserve(n);
+  Costs costs;
+  costs.push_back(Measure(n, [&] {
+    for (size_t i = 0; i < n; ++i) owners.emplace_back(new Payload);
+  }));
+  costs.push_back(Measure(n, [&] {
+    for (size_t i = 0; i < n; ++i) made.push_back(P::template Make<Payload>());
+  }));
+  costs.push_back(Measure(n, [&] {
+    for (const Shared& owner : owners) copies.push_back(owner);
+  }));
+  costs.push_back(Measure(n, [&] {
+    for (Shared& copy : copies) moved.push_back(std::move(copy));
+  }));
+  costs.push_back(Measure(n, [&] {
+    for (const Shared& owner : owners) grown.push_back(owner);
+  }));
+  // the objects stay alive, only the counts go down
+  costs.push_back(Measure(n, [&] {
+    moved.clear();
+    grown.clear();
+  }));
+  costs.back().ns /= 2;
+  costs.back().allocs /= 2;
+  for (const Shared& owner : owners) weaks.emplace_back(owner);
+  costs.push_back(Measure(n, [&] {
+    uint64_t sink = 0;
+    for (const Weak& weak : weaks) sink += P::Lock(weak)->values[0];
+    asm volatile("" : : "r"(sink));
+  }));
+  // the last owner: the object and, unless a WeakPtr holds it, the block
+  weaks.clear();
+  costs.push_back(Measure(n, [&] { owners.clear(); }));
+  costs.push_back(Measure(n, [&] { made.clear(); }));
+  return costs;
+}
+
+const char* const kSharedRows[] = {"new+construct", "Make",          "copy",
+                                   "move",          "vector growth", "drop a copy",
+                                   "Lock()+drop",   "destroy",       "destroy Make"};
+
+// threads copy and drop, or lock and drop, the same pointer n times each
+template <typename P>
+Costs CrossThreadCosts(size_t n, int threads) {
+  using Shared = typename P::template Shared<Payload>;
+  using Weak = typename P::template Weak<Payload>;
+  Shared shared = P::template Make<Payload>();
+  Weak weak(shared);
+  auto run = [&](auto body) {
+    return Measure(n * threads, [&] {
+      std::vector<std::thread> workers;
+      for (int i = 0; i < threads; ++i) workers.emplace_back(body);
+      for (std::thread& worker : workers) worker.join();
+    });
+  };
+  Costs costs;
+  costs.push_back(run([&] {
+    uint64_t sink = 0;
+    for (size_t i = 0; i < n; ++i) {
+      Shared copy(shared);
+      sink += copy->values[0];
+    }
+    asm volatile("" : : "r"(sink));
+  }));
+  costs.push_back(run([&] {
+    uint64_t sink = 0;
+    for (size_t i = 0; i < n; ++i) sink += P::Lock(weak)->values[0];
+    asm volatile("" : : "r"(sink));
+  }));
+  return costs;
+}
+
+const char* const kCrossThreadRows[] = {"copy+drop", "Lock()+drop"};
+
+// This thread makes n pointers with make() and hands them over in batches to a consumer thread,
+// which drops them.
+template <typename P, typename Make>
+Cost Handoff(size_t n, Make make) {
+  using Batch = std::vector<typename P::template Shared<Payload>>;
+  const size_t kBatch = 256;
+  std::mutex mutex;
+  std::condition_variable cond;
+  std::deque<Batch> batches;
+  bool done = false;
+  return Measure(n, [&] {
+    std::thread consumer([&] {
+      std::unique_lock<std::mutex> lock(mutex);
+      while (true) {
+        while (batches.empty() && !done) cond.wait(lock);
+        if (batches.empty()) break;
+        Batch batch = std::move(batches.front());
+        batches.pop_front();
+        lock.unlock();
+        batch.clear();
+        lock.lock();
+      }
+    });
+    Batch batch;
+    batch.reserve(kBatch);
+    for (size_t i = 0; i < n; ++i) {
+      batch.push_back(make());
+      if (batch.size() == kBatch || i == n - 1) {
+        std::lock_guard<std::mutex> lock(mutex);
+        batches.push_back(std::move(batch));
+        batch = Batch();
+        batch.reserve(kBatch);
+        cond.notify_one();
+      }
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      done = true;
+      cond.notify_one();
+    }
+    consumer.join();
+    P::Drain();
+  });
+}
+
+// copies of one pointer, then new objects, released on the consumer thread
+template <typename P>
+Costs HandoffCosts(size_t n) {
+  using Shared = typename P::template Shared<Payload>;
+  Shared shared = P::template Make<Payload>();
+  Costs costs;
+  costs.push_back(Handoff<P>(n, [&] { return shared; }));
+  costs.push_back(Handoff<P>(n, [] { return P::template Make<Payload>(); }));
+  return costs;
+}
+
+const char* const kHandoffRows[] = {"copy, drop there", "Make, drop there"};
+
+template <size_t N>
+void Print(const char* title, const char* const (&rows)[N], const std::vector<const char*>& names,
+           const std::vector<Costs>& columns) {
+  printf("\n%-20s", title);
+  for (const char* name : names) printf(" %22s", name);
+  printf("\n%-20s", "");
+  for (size_t i = 0; i < names.size(); ++i) printf(" %12s %9s", "ns", "allocs");
+  printf("\n");
+  for (size_t row = 0; row < N; ++row) {
+    printf("%-20s", rows[row]);
+    for (const Costs& costs : columns) printf(" %12.2f %9.3f", costs[row].ns, costs[row].allocs);
+    printf("\n");
+  }
+}
+
+int main(int argc, char* argv[]) {
+  size_t n = argc > 1 ? strtoul(argv[1], nullptr, 10) : 1 << 20;
+  int threads = argc > 2 ? atoi(argv[2]) : 4;
+
+  // so that the first column does not pay for growing the heap
+  SharedCosts<Std>(n);
+
+  Print("unique", kUniqueRows, {"std::unique_ptr", "UniquePtr"},
+        {UniqueCosts<Std>(n), UniqueCosts<Ours<NonAtomicCount>>(n)});
+
+  Print("shared", kSharedRows, {"std::shared_ptr", "SharedPtr", "SharedPtr AtomicCount"},
+        {SharedCosts<Std>(n), SharedCosts<Ours<NonAtomicCount>>(n),
+         SharedCosts<Ours<AtomicCount>>(n)});
+
+  char title[32];
+  snprintf(title, sizeof(title), "%d threads", threads);
+  Print(title, kCrossThreadRows, {"std::shared_ptr", "SharedPtr AtomicCount"},
+        {CrossThreadCosts<Std>(n, threads), CrossThreadCosts<Ours<AtomicCount>>(n, threads)});
+
+  Print("handoff", kHandoffRows,
+        {"std::shared_ptr", "SharedPtr AtomicCount", "SharedPtr BiasedCount", "DeferredDelete"},
+        {HandoffCosts<Std>(n), HandoffCosts<Ours<AtomicCount>>(n), HandoffCosts<OursBiased>(n),
+         HandoffCosts<OursDeferred>(n)});
+
+  return 0;
+}
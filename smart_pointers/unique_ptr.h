@@ -2,64 +2,231 @@
 #define UNIQUE_PTR_H_
 
 #include <cassert>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
 #include <utility>
 
-template <typename T>
+// Deleter is called as deleter(data) to release the object. An empty deleter, such as the default
+// std::default_delete<T> or a captureless lambda type, takes no space, so UniquePtr is one pointer
+// wide:
+//   UniquePtr<Foo> up(new Foo);
+//   UniquePtr<Foo, PoolDelete<Foo>> up(new (PoolAlloc(sizeof(Foo))) Foo);
+//   UniquePtr<int[]> up(new int[n]);
+// Moves are noexcept, so std::vector relocates UniquePtrs by moving them.
+
+namespace unique_internal {
+
+// data and deleter, with an empty, non-final Deleter as a base so it takes no space
+template <typename T, typename Deleter,
+          bool = std::is_empty<Deleter>::value && !std::is_final<Deleter>::value>
+class Storage : private Deleter {
+ public:
+  Storage() noexcept = default;
+
+  Storage(T* data, Deleter deleter) noexcept : Deleter(std::move(deleter)), data_(data) {}
+
+  T*& Data() noexcept { return data_; }
+
+  T* Data() const noexcept { return data_; }
+
+  Deleter& GetDeleter() noexcept { return *this; }
+
+  const Deleter& GetDeleter() const noexcept { return *this; }
+
+ private:
+  T* data_ = nullptr;
+};
+
+template <typename T, typename Deleter>
+class Storage<T, Deleter, false> {
+ public:
+  Storage() noexcept = default;
+
+  Storage(T* data, Deleter deleter) noexcept : data_(data), deleter_(std::move(deleter)) {}
+
+  T*& Data() noexcept { return data_; }
+
+  T* Data() const noexcept { return data_; }
+
+  Deleter& GetDeleter() noexcept { return deleter_; }
+
+  const Deleter& GetDeleter() const noexcept { return deleter_; }
+
+ private:
+  T* data_ = nullptr;
+  Deleter deleter_{};
+};
+
+// UniquePtr<U, D> moves into UniquePtr<T, Deleter>
+template <typename T, typename Deleter, typename U, typename D>
+using EnableConversion =
+    std::enable_if_t<!std::is_array<U>::value && std::is_convertible<U*, T*>::value &&
+                     std::is_convertible<D, Deleter>::value>;
+
+// U* may be stored in UniquePtr<T[]>: T itself, or T with more cv-qualifiers, never a derived
+// class
+template <typename T, typename U>
+using EnableArrayPointer = std::enable_if_t<std::is_convertible<U (*)[], T (*)[]>::value>;
+
+}  // namespace unique_internal
+
+template <typename T, typename Deleter = std::default_delete<T>>
 class UniquePtr {
+  template <typename U, typename D>
+  friend class UniquePtr;
+
  public:
   UniquePtr() noexcept = default;
 
-  explicit UniquePtr(T* data) : data_(data) {}
+  explicit UniquePtr(T* data) noexcept : storage_(data, Deleter()) {
+    static_assert(!std::is_pointer<Deleter>::value, "a function pointer deleter must be passed");
+  }
+
+  UniquePtr(T* data, Deleter deleter) noexcept : storage_(data, std::move(deleter)) {}
 
   UniquePtr(const UniquePtr& other) = delete;
 
-  UniquePtr(UniquePtr&& other) : data_(other.data_) { other.data_ = nullptr; }
+  UniquePtr(UniquePtr&& other) noexcept
+      : storage_(other.Release(), std::move(other.GetDeleter())) {}
 
-  ~UniquePtr() {
-    delete data_;
-    data_ = nullptr;
-  }
+  // UniquePtr<Base> up(UniquePtr<Derived>(new Derived));
+  template <typename U, typename D,
+            typename = unique_internal::EnableConversion<T, Deleter, U, D>>
+  UniquePtr(UniquePtr<U, D>&& other) noexcept
+      : storage_(other.Release(), std::move(other.GetDeleter())) {}
+
+  ~UniquePtr() { Reset(); }
 
   UniquePtr& operator=(const UniquePtr& other) = delete;
 
+  // UniquePtr<int> p(new int(2022));
+  // p = std::move(p);
+  // OK, p still owns the int
   UniquePtr& operator=(UniquePtr&& other) noexcept {
-    swap(other);
-    other.Reset();
+    Reset(other.Release());
+    GetDeleter() = std::move(other.GetDeleter());
+    return *this;
+  }
+
+  template <typename U, typename D,
+            typename = unique_internal::EnableConversion<T, Deleter, U, D>>
+  UniquePtr& operator=(UniquePtr<U, D>&& other) noexcept {
+    Reset(other.Release());
+    GetDeleter() = std::move(other.GetDeleter());
     return *this;
   }
 
   T& operator*() const noexcept {
-    assert(data_ != nullptr);
-    return *data_;
+    assert(Get() != nullptr);
+    return *Get();
   }
 
   T* operator->() const noexcept {
-    assert(data_ != nullptr);
-    return data_;
+    assert(Get() != nullptr);
+    return Get();
   }
 
-  explicit operator bool() const noexcept { return data_ != nullptr; }
+  explicit operator bool() const noexcept { return Get() != nullptr; }
+
+  T* Get() const noexcept { return storage_.Data(); }
 
-  T* Get() const noexcept { return data_; }
+  Deleter& GetDeleter() noexcept { return storage_.GetDeleter(); }
+
+  const Deleter& GetDeleter() const noexcept { return storage_.GetDeleter(); }
 
   T* Release() noexcept {
-    T* tmp = data_;
-    data_ = nullptr;
+    T* tmp = storage_.Data();
+    storage_.Data() = nullptr;
     return tmp;
   }
 
+  // The new pointer is stored before the old object is released, so a destructor that reaches
+  // back into this UniquePtr sees the new one.
   void Reset(T* data = nullptr) noexcept {
-    delete data_;
-    data_ = data;
+    T* old = storage_.Data();
+    storage_.Data() = data;
+    if (old) GetDeleter()(old);
   }
 
   void swap(UniquePtr& other) noexcept {
     using std::swap;
-    swap(data_, other.data_);
+    swap(storage_, other.storage_);
   }
 
  private:
-  T* data_ = nullptr;
+  unique_internal::Storage<T, Deleter> storage_;
+};
+
+// Owns an array, released with delete[] by default:
+//   UniquePtr<int[]> up(new int[n]());
+//   up[0] = 1;
+// Only T* is accepted, not Derived*, since indexing or deleting through Base* would be wrong.
+template <typename T, typename Deleter>
+class UniquePtr<T[], Deleter> {
+ public:
+  UniquePtr() noexcept = default;
+
+  explicit UniquePtr(std::nullptr_t) noexcept {}
+
+  template <typename U, typename = unique_internal::EnableArrayPointer<T, U>>
+  explicit UniquePtr(U* data) noexcept : storage_(data, Deleter()) {
+    static_assert(!std::is_pointer<Deleter>::value, "a function pointer deleter must be passed");
+  }
+
+  template <typename U, typename = unique_internal::EnableArrayPointer<T, U>>
+  UniquePtr(U* data, Deleter deleter) noexcept : storage_(data, std::move(deleter)) {}
+
+  UniquePtr(const UniquePtr& other) = delete;
+
+  UniquePtr(UniquePtr&& other) noexcept
+      : storage_(other.Release(), std::move(other.GetDeleter())) {}
+
+  ~UniquePtr() { Reset(); }
+
+  UniquePtr& operator=(const UniquePtr& other) = delete;
+
+  UniquePtr& operator=(UniquePtr&& other) noexcept {
+    Reset(other.Release());
+    GetDeleter() = std::move(other.GetDeleter());
+    return *this;
+  }
+
+  T& operator[](size_t i) const noexcept {
+    assert(Get() != nullptr);
+    return Get()[i];
+  }
+
+  explicit operator bool() const noexcept { return Get() != nullptr; }
+
+  T* Get() const noexcept { return storage_.Data(); }
+
+  Deleter& GetDeleter() noexcept { return storage_.GetDeleter(); }
+
+  const Deleter& GetDeleter() const noexcept { return storage_.GetDeleter(); }
+
+  T* Release() noexcept {
+    T* tmp = storage_.Data();
+    storage_.Data() = nullptr;
+    return tmp;
+  }
+
+  template <typename U, typename = unique_internal::EnableArrayPointer<T, U>>
+  void Reset(U* data) noexcept {
+    T* old = storage_.Data();
+    storage_.Data() = data;
+    if (old) GetDeleter()(old);
+  }
+
+  void Reset(std::nullptr_t = nullptr) noexcept { Reset(static_cast<T*>(nullptr)); }
+
+  void swap(UniquePtr& other) noexcept {
+    using std::swap;
+    swap(storage_, other.storage_);
+  }
+
+ private:
+  unique_internal::Storage<T, Deleter> storage_;
 };
 
 #endif  // UNIQUE_PTR_H_
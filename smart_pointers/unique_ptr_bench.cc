@@ -0,0 +1,74 @@
+// Growing a std::vector of owning pointers one push_back at a time, with no reserve(): raw
+// pointers, std::unique_ptr, UniquePtr with its empty default deleter, and UniquePtr with a
+// function pointer deleter, which doubles its size. Every reallocation moves the elements, so
+// the cost follows sizeof and whether the move is noexcept.
+//   g++ -std=c++17 -O2 unique_ptr_bench.cc -o unique_ptr_bench
+//   ./unique_ptr_bench [elements]
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include "unique_ptr.h"
+
+struct Payload {
+  uint64_t value;
+};
+
+static void Delete(Payload* payload) { delete payload; }
+
+template <typename Ptr>
+Ptr Wrap(Payload* payload) {
+  if constexpr (std::is_same<Ptr, Payload*>::value) {
+    return payload;
+  } else if constexpr (std::is_same<Ptr, UniquePtr<Payload, void (*)(Payload*)>>::value) {
+    return Ptr(payload, Delete);
+  } else {
+    return Ptr(payload);
+  }
+}
+
+template <typename Ptr>
+void Run(const char* name, const std::vector<Payload*>& payloads, int rounds) {
+  double ns = 0;
+  for (int round = 0; round < rounds; ++round) {
+    std::vector<Ptr> ptrs;
+    auto start = std::chrono::steady_clock::now();
+    for (Payload* payload : payloads) ptrs.push_back(Wrap<Ptr>(payload));
+    ns += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start)
+              .count();
+    asm volatile("" : : "r"(ptrs.data()) : "memory");
+    // the payloads are reused by the next round
+    if constexpr (!std::is_same<Ptr, Payload*>::value) {
+      for (Ptr& ptr : ptrs) {
+        if constexpr (std::is_same<Ptr, std::unique_ptr<Payload>>::value)
+          ptr.release();
+        else
+          ptr.Release();
+      }
+    }
+  }
+  printf("%-24s %8zu %14.2f %12s\n", name, sizeof(Ptr), ns / rounds / payloads.size(),
+         std::is_nothrow_move_constructible<Ptr>::value ? "yes" : "no");
+}
+
+int main(int argc, char* argv[]) {
+  size_t n = argc > 1 ? strtoul(argv[1], nullptr, 10) : 1 << 20;
+  const int kRounds = 20;
+
+  std::vector<Payload*> payloads;
+  for (size_t i = 0; i < n; ++i) payloads.push_back(new Payload{i});
+
+  printf("%-24s %8s %14s %12s\n", "", "sizeof", "ns/push_back", "noexcept");
+  Run<Payload*>("Payload*", payloads, kRounds);
+  Run<std::unique_ptr<Payload>>("std::unique_ptr", payloads, kRounds);
+  Run<UniquePtr<Payload>>("UniquePtr", payloads, kRounds);
+  Run<UniquePtr<Payload, void (*)(Payload*)>>("UniquePtr, fn deleter", payloads, kRounds);
+
+  for (Payload* payload : payloads) delete payload;
+  return 0;
+}
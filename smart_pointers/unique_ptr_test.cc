@@ -1,5 +1,20 @@
 #include "unique_ptr.h"
 
+#include <type_traits>
+#include <vector>
+
+#include "pool_allocator.h"
+
+struct Counted {
+  explicit Counted(int* destroyed) : destroyed(destroyed) {}
+  virtual ~Counted() { ++*destroyed; }
+  int* destroyed;
+};
+
+struct Derived : Counted {
+  using Counted::Counted;
+};
+
 void TestUniquePtr() {
   {
     UniquePtr<int> up1(new int(1));
@@ -38,7 +53,103 @@ void TestUniquePtr() {
   }
 }
 
+void TestDeleter() {
+  // empty deleters take no space
+  static_assert(sizeof(UniquePtr<int>) == sizeof(int*), "");
+  static_assert(sizeof(UniquePtr<int, PoolDelete<int>>) == sizeof(int*), "");
+  static_assert(sizeof(UniquePtr<int[]>) == sizeof(int*), "");
+  static_assert(std::is_nothrow_move_constructible<UniquePtr<int>>::value, "");
+  static_assert(std::is_nothrow_move_assignable<UniquePtr<int>>::value, "");
+
+  {
+    int destroyed = 0;
+    int released = 0;
+    auto deleter = [&released](Counted* counted) {
+      ++released;
+      delete counted;
+    };
+    {
+      UniquePtr<Counted, decltype(deleter)> up1(new Counted(&destroyed), deleter);
+      UniquePtr<Counted, decltype(deleter)> up2(std::move(up1));
+      assert(!up1);
+      assert(released == 0);
+    }
+    assert(destroyed == 1);
+    assert(released == 1);
+  }
+
+  {
+    int destroyed = 0;
+    {
+      UniquePtr<Counted, PoolDelete<Counted>> up1(new (PoolAlloc(sizeof(Counted)))
+                                                      Counted(&destroyed));
+      up1 = std::move(up1);
+      assert(up1);
+    }
+    assert(destroyed == 1);
+  }
+
+  {
+    int destroyed = 0;
+    UniquePtr<Counted> up1(UniquePtr<Derived>(new Derived(&destroyed)));
+    up1 = UniquePtr<Derived>(new Derived(&destroyed));
+    assert(destroyed == 1);
+    up1.Reset();
+    assert(destroyed == 2);
+  }
+
+  // vector growth moves, and nothing is destroyed until the vector is
+  {
+    int destroyed = 0;
+    {
+      std::vector<UniquePtr<Counted>> ups;
+      for (int i = 0; i < 100; ++i) ups.emplace_back(new Counted(&destroyed));
+      assert(destroyed == 0);
+    }
+    assert(destroyed == 100);
+  }
+}
+
+void TestArray() {
+  // only T*, not a derived or unrelated pointer
+  static_assert(!std::is_constructible<UniquePtr<Counted[]>, Derived*>::value, "");
+  static_assert(!std::is_constructible<UniquePtr<Counted[]>, int*>::value, "");
+  static_assert(std::is_constructible<UniquePtr<const Counted[]>, Counted*>::value, "");
+  static_assert(!std::is_constructible<UniquePtr<Counted>, UniquePtr<int>&&>::value, "");
+  static_assert(!std::is_constructible<UniquePtr<Counted>, UniquePtr<Derived[]>&&>::value, "");
+  static_assert(!std::is_constructible<UniquePtr<Derived>, UniquePtr<Counted>&&>::value, "");
+  static_assert(std::is_constructible<UniquePtr<Counted>, UniquePtr<Derived>&&>::value, "");
+  static_assert(!std::is_assignable<UniquePtr<Counted>&, UniquePtr<int>&&>::value, "");
+
+  {
+    UniquePtr<int[]> up1(new int[3]());
+    up1[1] = 1;
+    assert(up1[0] == 0);
+    assert(up1[1] == 1);
+    UniquePtr<int[]> up2(std::move(up1));
+    assert(!up1);
+    assert(up2[1] == 1);
+    up2.Reset(new int[2]());
+    assert(up2[0] == 0);
+    up2.Reset(nullptr);
+    assert(!up2);
+    UniquePtr<int[]> up3(nullptr);
+    assert(!up3);
+  }
+
+  {
+    int destroyed = 0;
+    {
+      UniquePtr<Counted[]> up1(new Counted[2]{Counted(&destroyed), Counted(&destroyed)});
+      assert(destroyed == 0);
+    }
+    assert(destroyed == 2);
+  }
+}
+
 int main() {
   TestUniquePtr();
+  TestDeleter();
+  TestArray();
   return 0;
 }
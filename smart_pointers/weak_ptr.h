@@ -5,30 +5,33 @@
 
 #include "shared_count.h"
 
-template <typename T>
+template <typename T, typename Count>
 class SharedPtr;
 
-template <typename T>
+template <typename T, typename Count = NonAtomicCount>
 class WeakPtr {
-  template <class U>
+  template <typename U, typename C>
   friend class SharedPtr;
 
+  template <typename U, typename C>
+  friend class WeakPtr;
+
  public:
   WeakPtr() noexcept = default;
 
   WeakPtr(const WeakPtr& other) noexcept : data_(other.data_), count_(other.count_) {
-    if (count_) ++count_->weak_count;
+    if (count_) count_->weak_count.Increment();
   }
 
-  WeakPtr(const SharedPtr<T>& other) noexcept : data_(other.data_), count_(other.count_) {
-    if (count_) ++count_->weak_count;
+  WeakPtr(const SharedPtr<T, Count>& other) noexcept : data_(other.data_), count_(other.count_) {
+    if (count_) count_->weak_count.Increment();
   }
 
   WeakPtr(WeakPtr&& other) noexcept { swap(other); }
 
   template <typename U>
-  WeakPtr(const WeakPtr<U>& other) noexcept : data_(other.data_), count_(other.count_) {
-    if (count_) ++count_->shared_count;
+  WeakPtr(const WeakPtr<U, Count>& other) noexcept : data_(other.data_), count_(other.count_) {
+    if (count_) count_->weak_count.Increment();
   }
 
   ~WeakPtr() { Decrement(); }
@@ -47,9 +50,11 @@ class WeakPtr {
     return *this;
   }
 
-  bool Expired() const noexcept { return !count_ || count_->shared_count == 0; }
+  bool Expired() const noexcept { return !count_ || count_->shared_count.Load() == 0; }
 
-  SharedPtr<T> Lock() const { return Expired() ? SharedPtr<T>(nullptr) : SharedPtr<T>(*this); }
+  // Expired() followed by a plain increment could revive an object that another thread is
+  // destroying, so SharedPtr's constructor checks and increments in one step.
+  SharedPtr<T, Count> Lock() const noexcept { return SharedPtr<T, Count>(*this); }
 
   void Reset() noexcept {
     Decrement();
@@ -64,19 +69,12 @@ class WeakPtr {
   }
 
  private:
-  void Decrement() {
-    if (!count_) return;
-
-    --count_->weak_count;
-
-    if (count_->shared_count == 0 && count_->weak_count == 0) {
-      delete count_;
-      count_ = nullptr;
-    }
+  void Decrement() noexcept {
+    if (count_) count_->WeakRelease();
   }
 
   T* data_ = nullptr;
-  SharedCount* count_ = nullptr;
+  SharedCount<Count>* count_ = nullptr;
 };
 
 #endif  // WEAK_PTR_H_
@@ -1,6 +1,10 @@
-#include "shared_ptr.h"
 #include "weak_ptr.h"
 
+#include <thread>
+#include <vector>
+
+#include "shared_ptr.h"
+
 void TestWeakPtr() {
   {
     WeakPtr<int> wp1;
@@ -71,9 +75,48 @@ void TestWeakPtr() {
     assert(!wp.Lock());
     assert(wp.Expired());
   }
+
+  {
+    class Base {};
+    class Derived : public Base {};
+    SharedPtr<Derived> sp1(new Derived);
+    WeakPtr<Derived> wp1(sp1);
+    WeakPtr<Base> wp2(wp1);
+    sp1.Reset();
+    assert(wp2.Expired());
+  }
+}
+
+struct Flagged {
+  ~Flagged() { __atomic_store_n(&alive, false, __ATOMIC_RELAXED); }
+  bool alive = true;
+};
+
+// Threads Lock() while the last SharedPtr is dropped. A Lock() that wins must see a live object,
+// and once the object is gone every Lock() must fail.
+void TestLockRace() {
+  const int kThreads = 4;
+  const int kRounds = 500;
+
+  for (int round = 0; round < kRounds; ++round) {
+    SharedPtr<Flagged, AtomicCount> sp(new Flagged);
+    WeakPtr<Flagged, AtomicCount> wp(sp);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < kThreads; ++i) {
+      threads.emplace_back([wp] {
+        while (SharedPtr<Flagged, AtomicCount> locked = wp.Lock()) {
+          assert(__atomic_load_n(&locked->alive, __ATOMIC_RELAXED));
+        }
+        assert(wp.Expired());
+      });
+    }
+    sp.Reset();
+    for (auto& t : threads) t.join();
+  }
 }
 
 int main() {
   TestWeakPtr();
+  TestLockRace();
   return 0;
 }
@@ -11,7 +11,7 @@ static void* ThrdpoolRoutine(void* arg) {
   auto pool = reinterpret_cast<Thrdpool*>(arg);
   pthread_setspecific(pool->key_, pool);
   while (!pool->terminate_) {
-    auto entry = reinterpret_cast<ThrdpoolTaskEntry*>(pool->msgqueue_->Get());
+    auto entry = pool->msgqueue_->Get();
     if (!entry) break;
 
     auto task_routine = entry->task.routine;
@@ -78,7 +78,8 @@ bool Thrdpool::CreateThreads(size_t nthreads) {
 }
 
 bool Thrdpool::Create(size_t nthreads, size_t stacksize) {
-  msgqueue_ = new MsgQueue(static_cast<size_t>(-1), 0);
+  msgqueue_ =
+      new TypedMsgQueue<ThrdpoolTaskEntry, &ThrdpoolTaskEntry::link>(static_cast<size_t>(-1));
   if (pthread_mutex_init(&mutex_, NULL) == 0) {
     if (pthread_key_create(&key_, NULL) == 0) {
       stacksize_ = stacksize;
@@ -122,7 +123,7 @@ void Thrdpool::Destroy(void (*pending)(const ThrdpoolTask&)) {
   bool in_pool = InPool();
   Terminate(in_pool);
   while (true) {
-    auto entry = reinterpret_cast<ThrdpoolTaskEntry*>(msgqueue_->Get());
+    auto entry = msgqueue_->Get();
     if (!entry) break;
 
     if (pending) pending(entry->task);
@@ -5,7 +5,7 @@
 
 #include <cstddef>
 
-#include "msgqueue.h"
+#include "typed_msgqueue.h"
 
 struct ThrdpoolTask {
   void (*routine)(void*);
@@ -48,7 +48,7 @@ class Thrdpool {
 
   static pthread_t zero_tid_;
 
-  MsgQueue* msgqueue_ = nullptr;
+  TypedMsgQueue<ThrdpoolTaskEntry, &ThrdpoolTaskEntry::link>* msgqueue_ = nullptr;
   size_t nthreads_ = 0;
   size_t stacksize_ = 0;
   pthread_t tid_;